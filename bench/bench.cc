@@ -0,0 +1,202 @@
+/**
+ * Native benchmark of the voro-js wrapper core.
+ *
+ * Times the phases of a tessellation separately for particles in a unit box,
+ * over a sweep of particle counts, block sizes, distributions (uniform, or
+ * clustered around 16 centers) and insertion orders (sorted or as given):
+ * - insert: the bulk insertion, spatially sorted or one particle at a time,
+ * - compute: the computation of the cells by voro++,
+ * - extract: reading the vertices, faces and neighbors of the cells,
+ * - pack: appending the cells to the flat output.
+ *
+ * The loop below reimplements that of VoronoiContext on the shared building
+ * blocks of voro_core.hh, as the context depends on embind; calls from
+ * JavaScript, field masks, threads, walls and the precision conversion are not
+ * part of the measurement.
+ *
+ * Build with `npm run build:bench` and run `bench/bench [--json] [--max N]`.
+ * The results are written to stdout as CSV, or JSON with --json.
+*/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../src/voro_core.hh"
+
+typedef std::chrono::steady_clock bench_clock;
+
+// the particle distributions of the sweep
+enum Distribution
+{
+	UNIFORM,
+	CLUSTERED
+};
+
+static const char* distribution_name(Distribution d)
+{
+	return d == UNIFORM ? "uniform" : "clustered";
+}
+
+struct BenchResult
+{
+	int count;
+	double particles_per_block;
+	Distribution distribution;
+	bool sorted;
+	int grid;
+	int cells;
+	double volume;
+	double insert_ms;
+	double compute_ms;
+	double extract_ms;
+	double pack_ms;
+};
+
+static double elapsed_ms(bench_clock::time_point t0, bench_clock::time_point t1)
+{
+	return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// the same generator as the tests, such that runs are reproducible
+static double next_random(double& s)
+{
+	s = std::fmod(s * 16807, 2147483647);
+	return s / 2147483647;
+}
+
+// generates count particles in the unit box, either uniformly distributed or
+// in 16 clusters of half-width 0.05 at uniformly distributed centers
+static void generate(int count, Distribution d, unsigned int seed, std::vector<double>& xyz)
+{
+	const int clusters = 16;
+	const double width = 0.05;
+	double s = seed;
+	std::vector<double> centers(3 * clusters);
+	for (double& c : centers)
+		c = width + (1 - 2 * width) * next_random(s);
+	xyz.resize(3 * static_cast<size_t>(count));
+	for (int i = 0; i < count; ++i)
+		for (int a = 0; a < 3; ++a)
+		{
+			double u = next_random(s);
+			xyz[3 * i + a] = d == UNIFORM ? u : centers[3 * (i % clusters) + a] + width * (2 * u - 1);
+		}
+}
+
+// tessellates count particles in the unit box with about particles_per_block
+// particles per block on average over the box
+static BenchResult run(int count, double particles_per_block, Distribution d, bool sorted, unsigned int seed)
+{
+	BenchResult res = {count, particles_per_block, d, sorted, 0, 0, 0, 0, 0, 0, 0};
+	res.grid = std::max(1, static_cast<int>(std::cbrt(count / particles_per_block)));
+
+	std::vector<int> ids(count);
+	for (int i = 0; i < count; ++i)
+		ids[i] = i;
+	std::vector<double> xyz;
+	generate(count, d, seed, xyz);
+
+	voro::container con(0, 1, 0, 1, 0, 1, res.grid, res.grid, res.grid, false, false, false, 8);
+	std::unordered_map<int, ParticleLocation> index;
+	SortedInserter inserter;
+	voro::particle_order order;
+	bench_clock::time_point t0 = bench_clock::now();
+	if (sorted)
+		inserter.insert(con, ids.data(), xyz.data(), xyz.data() + 1, xyz.data() + 2, nullptr, 3, count, index);
+	else
+	{
+		// one particle at a time in the given order, indexed like put_indexed
+		for (int i = 0; i < count; ++i)
+		{
+			order.op = order.o;
+			put_particle(con, order, ids[i], xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], 0);
+			if (order.op != order.o)
+				index[ids[i]] = {order.o[0], order.o[1]};
+		}
+	}
+	res.insert_ms = elapsed_ms(t0, bench_clock::now());
+
+	// the phases alternate for every cell, so each one is timed per cell
+	CellComputer<voro::container> computer(con);
+	voro::voronoicell_neighbor c;
+	ExtractScratch scratch;
+	VoronoiCellsFlat out;
+	bench_clock::duration compute(0), extract(0), pack(0);
+	for (int ijk = 0; ijk < con.nxyz; ++ijk)
+		for (int q = 0; q < con.co[ijk]; ++q)
+		{
+			bench_clock::time_point t1 = bench_clock::now();
+			bool ok = computer.compute_cell(c, ijk, q);
+			bench_clock::time_point t2 = bench_clock::now();
+			compute += t2 - t1;
+			if (!ok)
+				continue;
+			const double* pp = con.p[ijk] + con.ps * q;
+			extract_cell_data(c, pp[0], pp[1], pp[2], CELL_ALL, scratch);
+			bench_clock::time_point t3 = bench_clock::now();
+			append_cell_flat(con.id[ijk][q], pp[0], pp[1], pp[2], CELL_ALL, scratch, out);
+			bench_clock::time_point t4 = bench_clock::now();
+			extract += t3 - t2;
+			pack += t4 - t3;
+			res.volume += scratch.volume;
+			// the output of a million cells does not fit into memory, it is
+			// dropped regularly while keeping its capacity
+			if (++res.cells % 65536 == 0)
+				out.clear();
+		}
+	res.compute_ms = std::chrono::duration<double, std::milli>(compute).count();
+	res.extract_ms = std::chrono::duration<double, std::milli>(extract).count();
+	res.pack_ms = std::chrono::duration<double, std::milli>(pack).count();
+	return res;
+}
+
+int main(int argc, char** argv)
+{
+	bool json = false;
+	int max_count = 1000000;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--json") == 0)
+			json = true;
+		else if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+			max_count = std::atoi(argv[++i]);
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--json] [--max N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const double block_sizes[] = {2, voro::optimal_particles, 16};
+	const Distribution distributions[] = {UNIFORM, CLUSTERED};
+	if (json)
+		std::printf("[\n");
+	else
+		std::printf("count,particles_per_block,distribution,sorted,grid,cells,volume,insert_ms,compute_ms,extract_ms,pack_ms\n");
+	bool first = true;
+	for (int count = 1000; count <= max_count; count *= 10)
+		for (double ppb : block_sizes)
+			for (Distribution d : distributions)
+				for (int sorted = 0; sorted < 2; ++sorted)
+				{
+					BenchResult r = run(count, ppb, d, sorted != 0, 42);
+					if (json)
+						std::printf("%s  {\"count\": %d, \"particlesPerBlock\": %g, \"distribution\": \"%s\", \"sorted\": %s, "
+							"\"grid\": %d, \"cells\": %d, \"volume\": %.9g, "
+							"\"insertMs\": %.3f, \"computeMs\": %.3f, \"extractMs\": %.3f, \"packMs\": %.3f}",
+							first ? "" : ",\n", r.count, r.particles_per_block, distribution_name(r.distribution), r.sorted ? "true" : "false",
+							r.grid, r.cells, r.volume, r.insert_ms, r.compute_ms, r.extract_ms, r.pack_ms);
+					else
+						std::printf("%d,%g,%s,%d,%d,%d,%.9g,%.3f,%.3f,%.3f,%.3f\n", r.count, r.particles_per_block,
+							distribution_name(r.distribution), r.sorted ? 1 : 0, r.grid, r.cells, r.volume,
+							r.insert_ms, r.compute_ms, r.extract_ms, r.pack_ms);
+					std::fflush(stdout);
+					first = false;
+				}
+	if (json)
+		std::printf("\n]\n");
+	return 0;
+}
@@ -65,6 +65,11 @@ function initApp(Voro: any) {
         1, 1, 1
     );
 
+    // Add static points (ID 1+) once, the mover (ID 0) is moved in place every frame.
+    staticPoints.forEach((p, i) => {
+        context.addPoint(i + 1, p.x, p.y, p.z);
+    });
+
     // Cell Mesh
     let cellMesh: THREE.LineSegments | null = null;
     const edgeMaterial = new THREE.LineBasicMaterial({
@@ -111,6 +116,11 @@ function initApp(Voro: any) {
         return { x, y, z };
     }
 
+    // Add the mover (ID 0) at the start of the curve, clamped to the container
+    const clamp = (v: number) => Math.max(bounds.min, Math.min(bounds.max, v));
+    const start = getCurvePoint(0, curveParams.type, curveParams.a);
+    context.addPoint(0, clamp(start.x), clamp(start.y), clamp(start.z));
+
     // Curve Visualization
     const curvePoints: THREE.Vector3[] = [];
     for(let t=0; t<=Math.PI*2; t+=0.05) {
@@ -150,15 +160,9 @@ function initApp(Voro: any) {
         controls.target.set(look.x, look.y, look.z);
 
         // 3. Update Voronoi
-        context.clear();
-        
-        // Add static points (ID 1+)
-        staticPoints.forEach((p, i) => {
-            context.addPoint(i + 1, p.x, p.y, p.z);
-        });
-
-        // Add mover (ID 0)
-        context.addPoint(0, pos.x, pos.y, pos.z);
+        // Move the mover (ID 0), only the cells around it are recomputed. It is
+        // clamped to the container, as moves out of it are rejected.
+        context.movePoint(0, clamp(pos.x), clamp(pos.y), clamp(pos.z));
 
         // 4. Get All Cells to render full structure
         const cells = context.getCells();
@@ -3,7 +3,7 @@ import { OrbitControls } from 'three/addons/controls/OrbitControls.js';
 import Stats from 'three/addons/libs/stats.module.js';
 import GUI from 'lil-gui';
 
-import { VoronoiWallTorus, VoronoiWallLemniscate, VoronoiWallCylinder } from './voronoi_walls';
+import { VoronoiWallTorus, VoronoiWallLemniscate, VoronoiWallCylinder, batchedWall } from './voronoi_walls';
 
 // --- Main Application ---
 import('../../dist/voro_browser.js').then((voroModule: any) => {
@@ -67,6 +67,7 @@ function initApp(Voro: any) {
     const params = {
         pointCount: 40,
         shape: 'Torus',
+        wall: 'Native',
         regenerate: () => resetSimulation()
     };
 
@@ -78,6 +79,7 @@ function initApp(Voro: any) {
     const gui = new GUI();
     gui.add(params, 'pointCount', 8, 200, 1).name('Point Count').onFinishChange(resetSimulation);
     gui.add(params, 'shape', ['Torus', 'Lemniscate', 'Cylinder']).name('Shape').onChange(resetSimulation);
+    gui.add(params, 'wall', ['Native', 'JS Batched', 'JS']).name('Wall').onChange(resetSimulation);
     gui.add(params, 'regenerate').name('Regenerate');
 
     // Integrate Stats into GUI
@@ -97,6 +99,35 @@ function initApp(Voro: any) {
         }
     }
 
+    // The same shapes as declarative walls, which are evaluated without calling into JS.
+    function nativeShape(shape: string): any {
+        switch (shape) {
+            case 'Torus':
+                return { type: 'torus', center: [0, 0, 0], majorRadius: 3, minorRadius: 1 };
+            case 'Lemniscate': {
+                // A tube of capsules along the curve.
+                const steps = 128, children = [];
+                const curve = (t: number) => {
+                    const den = 1 + Math.sin(t)**2;
+                    return [3 * Math.cos(t) / den, 3 * Math.sin(t) * Math.cos(t) / den, 0];
+                };
+                for (let i = 0; i < steps; i++) {
+                    const a = curve((2 * Math.PI * i) / steps);
+                    const b = curve((2 * Math.PI * (i + 1)) / steps);
+                    children.push({ type: 'capsule', a, b, radius: 1 });
+                }
+                return { type: 'union', children };
+            }
+            case 'Cylinder':
+                return { type: 'intersection', children: [
+                    { type: 'capsule', a: [0, 0, -2], b: [0, 0, 2], radius: 3 },
+                    { type: 'halfspace', normal: [0, 0, 1], d: 2 },
+                    { type: 'halfspace', normal: [0, 0, -1], d: 2 }
+                ] };
+        }
+        return null;
+    }
+
     function initContext() {
         if (context) context.delete();
         context = new Voro.VoronoiContext3D(
@@ -108,7 +139,9 @@ function initApp(Voro: any) {
 
         // Add Selected Wall
         let wall;
-        switch (params.shape) {
+        if (params.wall === 'Native') {
+            context.addWallSDF(nativeShape(params.shape), -7);
+        } else switch (params.shape) {
             case 'Torus':
                 wall = new VoronoiWallTorus(3, 1);
                 break;
@@ -120,7 +153,10 @@ function initApp(Voro: any) {
                 break;
         }
         if (wall) {
-            context.addWallJS(wall);
+            if (params.wall === 'JS Batched')
+                context.addWallJSBatched(batchedWall(wall), -7);
+            else
+                context.addWallJS(wall);
         }
 
         // Add static points once
@@ -152,18 +152,14 @@ function initApp(Voro: any) {
     }
 
     function updateVoronoi() {
-        // 1. Clear and Re-populate
-        context.clear();
-        
-        points.forEach((p, i) => {
-            context.addPoint(i + 1, p.x, p.y, p.z);
-        });
-        context.addPoint(0, mover.x, mover.y, mover.z);
+        // 1. Move the mover in place, only the cells around it are recomputed.
+        // It is clamped to the bounds, so the move is never rejected.
+        context.movePoint(0, mover.x, mover.y, mover.z);
 
-        // 3. Compute Cells
+        // 2. Compute Cells
         const cells = context.getCells();
 
-        // 4. Build Geometry
+        // 3. Build Geometry
         const staticPositions: number[] = [];
         const moverPositions: number[] = [];
 
@@ -187,7 +183,7 @@ function initApp(Voro: any) {
             }
         });
 
-        // 5. Update Visualization
+        // 4. Update Visualization
         if (staticMesh) {
             pivot.remove(staticMesh);
             staticMesh.geometry.dispose();
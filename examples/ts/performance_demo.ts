@@ -62,6 +62,10 @@ function initApp(Voro: any) {
         cameraType: 'Perspective',
         count: 1000,
         boxSize: 20,
+        distribution: 'Uniform',
+        autoGrid: true,
+        sortedInsert: true,
+        chunked: false,
         n: 10,
         render: true,
         run: () => runBenchmark(),
@@ -82,9 +86,13 @@ function initApp(Voro: any) {
         activeCamera.rotation.copy(prevCamera.rotation);
         controls.object = activeCamera;
     });
-    gui.add(params, 'count', 100, 50000, 100).name('Particle Count');
+    gui.add(params, 'count', 100, 1000000, 100).name('Particle Count');
+    gui.add(params, 'distribution', ['Uniform', 'Clustered']).name('Distribution');
     gui.add(params, 'boxSize', 10, 100).name('Box Size');
+    gui.add(params, 'autoGrid').name('Auto Grid');
     gui.add(params, 'n', 1, 50, 1).name('Grid Size (n)');
+    gui.add(params, 'sortedInsert').name('Sorted Insertion');
+    gui.add(params, 'chunked').name('Chunked (per frame)');
     gui.add(params, 'render').name('Render Result');
     gui.add(params, 'run').name('Run Benchmark');
     gui.add(params, 'download').name('Download CSV');
@@ -103,77 +111,81 @@ function initApp(Voro: any) {
         }
 
         // Use setTimeout to allow UI to update before heavy processing
-        setTimeout(() => {
+        setTimeout(async () => {
             try {
                 // 1. Data Generation (JS Side)
                 const t0 = performance.now();
                 const ids = new Int32Array(params.count);
-                const x = new Float64Array(params.count);
-                const y = new Float64Array(params.count);
-                const z = new Float64Array(params.count);
+                const xyz = new Float64Array(3 * params.count);
+
+                // Clustered points are spread around 20 random centers.
+                const centers: number[] = [];
+                for(let c=0; c<60; c++) centers.push((Math.random() - 0.5) * params.boxSize * 0.8);
+                const spread = params.boxSize * 0.05;
 
                 for(let i=0; i<params.count; i++) {
                     ids[i] = i;
-                    x[i] = (Math.random() - 0.5) * params.boxSize;
-                    y[i] = (Math.random() - 0.5) * params.boxSize;
-                    z[i] = (Math.random() - 0.5) * params.boxSize;
+                    if (params.distribution === 'Clustered') {
+                        const c = 3 * Math.floor(Math.random() * 20);
+                        for(let a=0; a<3; a++) {
+                            const r = Math.sqrt(-2 * Math.log(1 - Math.random())) * Math.cos(2 * Math.PI * Math.random());
+                            xyz[3*i+a] = Math.max(-params.boxSize / 2, Math.min(params.boxSize / 2 - 1e-9, centers[c+a] + r * spread));
+                        }
+                    } else {
+                        xyz[3*i] = (Math.random() - 0.5) * params.boxSize;
+                        xyz[3*i+1] = (Math.random() - 0.5) * params.boxSize;
+                        xyz[3*i+2] = (Math.random() - 0.5) * params.boxSize;
+                    }
                 }
                 const tGen = performance.now() - t0;
 
-                // 2. Data Marshalling (JS -> C++)
-                const t1 = performance.now();
-                const emIds = new Voro.VectorInt();
-                const emX = new Voro.VectorDouble();
-                const emY = new Voro.VectorDouble();
-                const emZ = new Voro.VectorDouble();
-
-                // Resize vectors first to avoid reallocations (if resize is exposed, otherwise push_back)
-                // The bindings use push_back in the test, let's stick to that or resize if available.
-                // Standard vector bindings usually expose push_back.
-                for(let i=0; i<params.count; i++) {
-                    emIds.push_back(ids[i]);
-                    emX.push_back(x[i]);
-                    emY.push_back(y[i]);
-                    emZ.push_back(z[i]);
-                }
-                const tMarshal = performance.now() - t1;
-
-                // 3. Context Initialization & Insertion
+                // 2. Context Initialization & Insertion
+                // The typed arrays are copied into the WebAssembly heap in one go.
                 const t2 = performance.now();
                 const half = params.boxSize / 2;
                 const n = params.n;
                 
-                const context = new Voro.VoronoiContext3D(
-                    -half, half, -half, half, -half, half,
-                    n, n, n
-                );
-                context.addPoints(emIds, emX, emY, emZ);
+                // The automatic grid is sized for the particle count.
+                const context = params.autoGrid
+                    ? new Voro.VoronoiContext3D(-half, half, -half, half, -half, half, params.count)
+                    : new Voro.VoronoiContext3D(-half, half, -half, half, -half, half, n, n, n);
+                context.setSortedInsert(params.sortedInsert);
+                context.addPointsFlat(ids, xyz);
                 const tInsert = performance.now() - t2;
 
-                // 4. Computation & Extraction
+                // 3. Computation & Extraction
                 const t3 = performance.now();
-                const cells = context.getCells(); // This returns JS array of objects
+                // Large inputs are only rendered as points, so the flat volumes suffice.
+                let cells: any[] = [];
+                if (params.chunked) {
+                    // Compute for at most 12 ms per frame, which keeps the page responsive.
+                    context.beginCompute(Voro.CELL_VOLUME);
+                    while (!context.isDone()) {
+                        const flat = context.computeChunk(0, 12);
+                        if (resultsDiv) resultsDiv.innerText = `Computing... ${flat.count} / ${params.count} cells`;
+                        await new Promise(requestAnimationFrame);
+                    }
+                }
+                else if (params.count > 50000) context.getCellsFlat(Voro.CELL_VOLUME);
+                else cells = context.getCells(); // This returns JS array of objects
                 const tCompute = performance.now() - t3;
+                const grid: number[] = context.getGrid();
 
                 // Cleanup C++ objects
                 context.delete();
-                emIds.delete();
-                emX.delete();
-                emY.delete();
-                emZ.delete();
 
-                // 5. Visualization (Optional)
+                // 4. Visualization (Optional)
                 visGroup.clear();
                 if (params.render) {
-                    if (params.count > 50000) {
+                    if (params.count > 50000 || params.chunked) {
                         // Render points only for performance
                         const geo = new THREE.BufferGeometry();
                         geo.setAttribute('position', new THREE.BufferAttribute(new Float32Array(params.count * 3), 3));
                         const pos = geo.attributes.position.array;
                         for(let i=0; i<params.count; i++) {
-                            pos[i*3] = x[i];
-                            pos[i*3+1] = y[i];
-                            pos[i*3+2] = z[i];
+                            pos[i*3] = xyz[i*3];
+                            pos[i*3+1] = xyz[i*3+1];
+                            pos[i*3+2] = xyz[i*3+2];
                         }
                         const mat = new THREE.PointsMaterial({ color: 0x00ff88, size: 0.2 });
                         visGroup.add(new THREE.Points(geo, mat));
@@ -200,16 +212,18 @@ function initApp(Voro: any) {
                 }
 
                 // Report
-                const total = tGen + tMarshal + tInsert + tCompute;
-                const particlesPerBox = params.count / (n * n * n);
+                const total = tGen + tInsert + tCompute;
+                const particlesPerBox = params.count / (grid[0] * grid[1] * grid[2]);
 
                 lastResults = {
                     count: params.count,
                     boxSize: params.boxSize,
-                    n: n,
+                    distribution: params.distribution,
+                    chunked: params.chunked,
+                    sorted: params.sortedInsert,
+                    grid: grid.join('x'),
                     particlesPerBox: particlesPerBox,
                     gen: tGen,
-                    marshal: tMarshal,
                     insert: tInsert,
                     compute: tCompute,
                     total: total
@@ -219,11 +233,13 @@ function initApp(Voro: any) {
                     resultsDiv.innerText = 
                         `Particles:    ${params.count}\n` +
                         `Box Size:     ${params.boxSize}\n` +
-                        `Grid (nxnxn): ${n}x${n}x${n}\n` +
+                        `Distribution: ${params.distribution}\n` +
+                        `Sorted:       ${params.sortedInsert ? 'yes' : 'no'}\n` +
+                        `Chunked:      ${params.chunked ? 'yes' : 'no'}\n` +
+                        `Grid:         ${grid.join('x')}\n` +
                         `Part/Box:     ${particlesPerBox.toFixed(2)}\n` +
                         `------------------------\n` +
                         `JS Gen:       ${tGen.toFixed(2)} ms\n` +
-                        `Marshalling:  ${tMarshal.toFixed(2)} ms\n` +
                         `Insertion:    ${tInsert.toFixed(2)} ms\n` +
                         `Compute+Extr: ${tCompute.toFixed(2)} ms\n` +
                         `------------------------\n` +
@@ -244,8 +260,8 @@ function initApp(Voro: any) {
             return;
         }
 
-        const headers = "Particles,Box Size,Grid N,Part/Box,JS Gen (ms),Marshalling (ms),Insertion (ms),Compute (ms),Total (ms)\n";
-        const row = `${lastResults.count},${lastResults.boxSize},${lastResults.n},${lastResults.particlesPerBox.toFixed(2)},${lastResults.gen.toFixed(2)},${lastResults.marshal.toFixed(2)},${lastResults.insert.toFixed(2)},${lastResults.compute.toFixed(2)},${lastResults.total.toFixed(2)}`;
+        const headers = "Particles,Box Size,Distribution,Sorted,Chunked,Grid,Part/Box,JS Gen (ms),Insertion (ms),Compute (ms),Total (ms)\n";
+        const row = `${lastResults.count},${lastResults.boxSize},${lastResults.distribution},${lastResults.sorted},${lastResults.chunked},${lastResults.grid},${lastResults.particlesPerBox.toFixed(2)},${lastResults.gen.toFixed(2)},${lastResults.insert.toFixed(2)},${lastResults.compute.toFixed(2)},${lastResults.total.toFixed(2)}`;
 
         const blob = new Blob([headers + row], { type: 'text/csv;charset=utf-8;' });
         const link = document.createElement("a");
@@ -3,63 +3,6 @@ import { OrbitControls } from 'three/addons/controls/OrbitControls.js';
 import GUI from 'lil-gui';
 import Stats from 'three/addons/libs/stats.module.js';
 
-// --- Centroid Calculation ---
-function computeCellCentroid(cell: any) {
-    if (!cell.vertices || cell.vertices.length === 0) return null;
-
-    let totalVolume = 0;
-    let weightedCentroid = { x: 0, y: 0, z: 0 };
-
-    // Compute geometric center of vertices to use as reference for tetrahedrons
-    // This improves numerical stability compared to using (0,0,0)
-    let cx = 0, cy = 0, cz = 0;
-    for(let v of cell.vertices) { cx += v.x; cy += v.y; cz += v.z; }
-    cx /= cell.vertices.length;
-    cy /= cell.vertices.length;
-    cz /= cell.vertices.length;
-
-    for (const face of cell.faces) {
-        // face is array of vertex indices. Triangulate face: (v0, vi, vi+1)
-        if (face.length < 3) continue;
-        const v0 = cell.vertices[face[0]];
-        for (let i = 1; i < face.length - 1; i++) {
-            const v1 = cell.vertices[face[i]];
-            const v2 = cell.vertices[face[i+1]];
-
-            // Tetrahedron (center, v0, v1, v2)
-            // Vectors from center
-            const x1 = v0.x - cx, y1 = v0.y - cy, z1 = v0.z - cz;
-            const x2 = v1.x - cx, y2 = v1.y - cy, z2 = v1.z - cz;
-            const x3 = v2.x - cx, y3 = v2.y - cy, z3 = v2.z - cz;
-
-            // Scalar triple product for volume * 6: (v1 . (v2 x v3))
-            const det = x1 * (y2 * z3 - z2 * y3) +
-                        y1 * (z2 * x3 - x2 * z3) +
-                        z1 * (x2 * y3 - y2 * x3);
-            
-            const vol = Math.abs(det) / 6.0;
-            
-            // Centroid of tetrahedron
-            const tx = (cx + v0.x + v1.x + v2.x) / 4.0;
-            const ty = (cy + v0.y + v1.y + v2.y) / 4.0;
-            const tz = (cz + v0.z + v1.z + v2.z) / 4.0;
-
-            totalVolume += vol;
-            weightedCentroid.x += vol * tx;
-            weightedCentroid.y += vol * ty;
-            weightedCentroid.z += vol * tz;
-        }
-    }
-
-    if (totalVolume <= 1e-9) return { x: cx, y: cy, z: cz };
-
-    return {
-        x: weightedCentroid.x / totalVolume,
-        y: weightedCentroid.y / totalVolume,
-        z: weightedCentroid.z / totalVolume
-    };
-}
-
 // --- Main Application ---
 import('../../dist/voro_browser.js').then((voroModule: any) => {
     return voroModule.default();
@@ -123,7 +66,7 @@ function initApp(Voro: any) {
         regenerate: () => resetSimulation()
     };
 
-    let points: {id: number, x: number, y: number, z: number}[] = [];
+    let context: any = null;
     let lastStepTime = 0;
     let cellMesh: THREE.Mesh | null = null;
 
@@ -141,90 +84,38 @@ function initApp(Voro: any) {
     statsFolder.domElement.querySelector('.children')?.appendChild(stats.dom);
 
     function generatePoints() {
-        points = [];
-        for (let i = 0; i < params.pointCount; i++) {
-            points.push({
-                id: i,
-                x: bounds.minX + Math.random() * (bounds.maxX - bounds.minX),
-                y: bounds.minY + Math.random() * (bounds.maxY - bounds.minY),
-                z: bounds.minZ + Math.random() * (bounds.maxZ - bounds.minZ)
-            });
-        }
-    }
-
-    function performRelaxationStep() {
-        // 1. Create Context
-        // Heuristic for block size: roughly cube root of N
-        const n = Math.ceil(Math.pow(params.pointCount, 1/3));
-        const context = new Voro.VoronoiContext3D(
+        // The blocks are sized for the number of points.
+        if (context) context.delete();
+        context = new Voro.VoronoiContext3D(
             bounds.minX, bounds.maxX,
             bounds.minY, bounds.maxY,
             bounds.minZ, bounds.maxZ,
-            n, n, n
+            params.pointCount
         );
+        for (let i = 0; i < params.pointCount; i++) {
+            context.addPoint(i,
+                bounds.minX + Math.random() * (bounds.maxX - bounds.minX),
+                bounds.minY + Math.random() * (bounds.maxY - bounds.minY),
+                bounds.minZ + Math.random() * (bounds.maxZ - bounds.minZ)
+            );
+        }
+    }
 
-        // 2. Add Points
-        points.forEach((p, i) => {
-            context.addPoint(i, p.x, p.y, p.z);
-        });
-
-        // 3. Compute Cells
-        const cells = context.getCells();
-
-        // 4. Compute Centroids & Update Points
-        const newPoints: typeof points = [];
-        const geometryData = {
-            positions: [] as number[],
-            colors: [] as number[],
-            normals: [] as number[]
-        };
+    function buildMesh() {
+        // Triangulated natively, with interleaved positions and normals.
+        const mesh = context.getRenderMesh();
+        const vertices = mesh.vertices.slice();
+        const colors = new Float32Array(vertices.length / 2);
 
         const color = new THREE.Color();
-
-        cells.forEach((cell: any, i: number) => {
-            // Compute centroid
-            const centroid = computeCellCentroid(cell);
-            if (centroid) {
-                newPoints.push({ id: i, x: centroid.x, y: centroid.y, z: centroid.z });
-            } else {
-                // Keep original if cell is degenerate (shouldn't happen in box)
-                newPoints.push(points[i]);
-            }
-
-            // Build Geometry
+        for (let i = 0; i < mesh.count; i++) {
             // Color based on position (stable visualization)
-            const cx = centroid ? centroid.x : points[i].x;
-            const cy = centroid ? centroid.y : points[i].y;
-            const cz = centroid ? centroid.z : points[i].z;
-            
-            // HSL color based on position in box
-            color.setHSL((cx / 10 + cy / 10 + cz / 10) / 3, 0.8, 0.5);
-
-            if (cell.vertices && cell.faces) {
-                cell.faces.forEach((face: number[]) => {
-                    if (face.length < 3) return;
-                    // Fan triangulation
-                    const v0 = cell.vertices[face[0]];
-                    for (let j = 1; j < face.length - 1; j++) {
-                        const v1 = cell.vertices[face[j]];
-                        const v2 = cell.vertices[face[j+1]];
-
-                        geometryData.positions.push(v0.x, v0.y, v0.z);
-                        geometryData.positions.push(v1.x, v1.y, v1.z);
-                        geometryData.positions.push(v2.x, v2.y, v2.z);
-
-                        geometryData.colors.push(color.r, color.g, color.b);
-                        geometryData.colors.push(color.r, color.g, color.b);
-                        geometryData.colors.push(color.r, color.g, color.b);
-                    }
-                });
-            }
-        });
-
-        // Update points for next step
-        points = newPoints;
+            const x = mesh.positions[3 * i], y = mesh.positions[3 * i + 1], z = mesh.positions[3 * i + 2];
+            color.setHSL((x / 10 + y / 10 + z / 10) / 3, 0.8, 0.5);
+            for (let v = mesh.vertexOffsets[i]; v < mesh.vertexOffsets[i + 1]; v++)
+                color.toArray(colors, 3 * v);
+        }
 
-        // 5. Update Visualization
         if (cellMesh) {
             pivot.remove(cellMesh);
             cellMesh.geometry.dispose();
@@ -236,9 +127,11 @@ function initApp(Voro: any) {
         }
 
         const geometry = new THREE.BufferGeometry();
-        geometry.setAttribute('position', new THREE.Float32BufferAttribute(geometryData.positions, 3));
-        geometry.setAttribute('color', new THREE.Float32BufferAttribute(geometryData.colors, 3));
-        geometry.computeVertexNormals();
+        const buffer = new THREE.InterleavedBuffer(vertices, 6);
+        geometry.setAttribute('position', new THREE.InterleavedBufferAttribute(buffer, 3, 0));
+        geometry.setAttribute('normal', new THREE.InterleavedBufferAttribute(buffer, 3, 3));
+        geometry.setAttribute('color', new THREE.BufferAttribute(colors, 3));
+        geometry.setIndex(new THREE.BufferAttribute(mesh.indices.slice(), 1));
 
         const material = new THREE.MeshStandardMaterial({
             vertexColors: true,
@@ -253,15 +146,17 @@ function initApp(Voro: any) {
         cellMesh = new THREE.Mesh(geometry, material);
         cellMesh.position.set(0, 0, 0);
         pivot.add(cellMesh);
+    }
 
-        // Cleanup
-        context.clear();
-        context.delete();
+    function performRelaxationStep() {
+        // Move every point to the centroid of its cell inside the module.
+        context.relax(1);
+        buildMesh();
     }
 
     function resetSimulation() {
         generatePoints();
-        performRelaxationStep(); // Initial render
+        buildMesh(); // Initial render
         lastStepTime = Date.now();
     }
 
@@ -179,5 +179,27 @@ class VoronoiWallCylinder
 	}
 }
 
+/**
+ * Wraps a wall for addWallJSBatched, which calls cut_cells once for all cells
+ * instead of cut_cell once per cell.
+ */
+function batchedWall(wall: { cut_cell(x: number, y: number, z: number): any })
+{
+	return {
+		cut_cells(positions: Float64Array)
+		{
+			const n = positions.length / 3;
+			const rows = new Float64Array(5 * n);
+			for (let i = 0; i < n; i++)
+			{
+				const cut = wall.cut_cell(positions[3*i], positions[3*i + 1], positions[3*i + 2]);
+				if (cut && cut.cut)
+					rows.set([1, cut.nx, cut.ny, cut.nz, cut.d], 5 * i);
+			}
+			return rows;
+		}
+	};
+}
+
 
-export { VoronoiWallTorus, VoronoiWallLemniscate, VoronoiWallCylinder };
+export { VoronoiWallTorus, VoronoiWallLemniscate, VoronoiWallCylinder, batchedWall };
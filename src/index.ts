@@ -20,32 +20,238 @@ export interface VectorDouble extends EmscriptenObject {
 	set(index: number, value: number): void;
 }
 
+/**
+ * Bit flags selecting the fields of a cell to compute, to be combined with `|`.
+ * Fields which are not requested stay empty (the volume is 0), the id and the
+ * position of a cell are always set. Flat output gets centroids with the volume.
+ */
+export const CellFields = {
+	VOLUME: 1,
+	VERTICES: 2,
+	FACES: 4,
+	EDGES: 8,
+	NEIGHBORS: 16,
+	ALL: 31
+} as const;
+
 export interface VoronoiCell3D extends EmscriptenObject {
 	updateBox(xmin: number, xmax: number, ymin: number, ymax: number, zmin: number, zmax: number): void;
 	cutPlane(x: number, y: number, z: number): boolean;
 	cutPlaneR(x: number, y: number, z: number, rsq: number): boolean;
-	getCellRaw(): any;
-	getCell(): any;
+	getCellRaw(fields?: number): any;
+	getCell(fields?: number): any;
+}
+
+/**
+ * A whole tessellation as typed array views on the WebAssembly heap. The entries
+ * of cell i are found between offsets[i] and offsets[i+1] of the respective
+ * offsets array. The views are reused by the next flat call on the same context
+ * and detach when the heap grows, so copy them (e.g. with `slice()`) to keep them.
+ * After `setPrecision(32)` the floating point arrays are Float32Arrays.
+ */
+export interface VoronoiCellsFlat {
+	count: number;
+	ids: Int32Array;
+	positions: Float64Array | Float32Array;
+	volumes: Float64Array | Float32Array;
+	centroids: Float64Array | Float32Array;
+	vertices: Float64Array | Float32Array;
+	vertexOffsets: Int32Array;
+	faceOffsets: Int32Array;
+	neighbors: Int32Array;
+	faceVertices: Int32Array;
+	faceVertexOffsets: Int32Array;
+	edges: Int32Array;
+	edgeOffsets: Int32Array;
+}
+
+// Neighbor graph of all cells in compressed sparse row form: the neighbors of
+// the particle ids[i] are neighbors[offsets[i]..offsets[i+1]), with the areas of
+// the shared faces at the same positions if requested. Contacts with walls and
+// the container boundary (negative ids) are indexed by wallOffsets instead.
+export interface NeighborGraph {
+	count: number;
+	ids: Int32Array;
+	offsets: Int32Array;
+	neighbors: Int32Array;
+	areas?: Float64Array;
+	wallOffsets: Int32Array;
+	walls: Int32Array;
+	wallAreas?: Float64Array;
+}
+
+// Options of VoronoiContext3D.getRenderMesh: per face vertices with the face
+// normal (flatNormals, the default) or vertices shared by the faces of a cell,
+// and a factor to scale each cell by around its centroid (shrink, 1 by default).
+export interface RenderMeshOptions {
+	flatNormals?: boolean;
+	shrink?: number;
+}
+
+/**
+ * Triangulated surfaces of all cells as typed array views on the WebAssembly
+ * heap, with the same lifetime as those of VoronoiCellsFlat. The vertices are
+ * interleaved as [px, py, pz, nx, ny, nz] and the triangles wind counterclockwise
+ * seen from outside. Cell i owns the vertices vertexOffsets[i]..vertexOffsets[i+1]
+ * and the draw range indexOffsets[i]..indexOffsets[i+1] of the index buffer.
+ */
+export interface RenderMesh {
+	count: number;
+	ids: Int32Array;
+	positions: Float64Array;
+	vertices: Float32Array;
+	indices: Uint32Array;
+	vertexOffsets: Int32Array;
+	indexOffsets: Int32Array;
+}
+
+// Result of VoronoiContext3D.getWireframe: every geometric edge of the
+// tessellation once, as segment end points [x1, y1, z1, x2, y2, z2, ...].
+export interface Wireframe {
+	count: number;
+	segments: Float32Array;
+}
+
+/**
+ * Declarative shape of a native wall, the cells are kept inside of it. Vectors
+ * are [x, y, z] arrays, a torus lies in the xy-plane around its center and a
+ * halfspace keeps nx*x + ny*y + nz*z <= d. A grid holds signed distances
+ * (negative inside) sampled at dims[0] x dims[1] x dims[2] points spanning
+ * min to max, indexed as i + dims[0] * (j + dims[1] * k).
+ */
+export type SdfShape =
+	| { type: 'sphere'; center: number[]; radius: number }
+	| { type: 'box'; min: number[]; max: number[] }
+	| { type: 'capsule'; a: number[]; b: number[]; radius: number }
+	| { type: 'torus'; center: number[]; majorRadius: number; minorRadius: number }
+	| { type: 'halfspace'; normal: number[]; d: number }
+	| { type: 'grid'; min: number[]; max: number[]; dims: number[]; values: Float64Array }
+	| { type: 'union' | 'intersection'; children: SdfShape[] };
+
+/**
+ * A JavaScript wall which cuts many cells per call. cut_cells receives the
+ * particle positions [x1, y1, z1, ...] and returns one row (cut, nx, ny, nz, d)
+ * per particle, a non-zero cut cuts the cell by the plane (nx, ny, nz, d) like
+ * the object returned by cut_cell of a wall for addWallJS. The positions are a
+ * view on the WebAssembly heap which is only valid during the call.
+ */
+export interface BatchedWall {
+	cut_cells(positions: Float64Array): Float64Array;
+	point_inside?(x: number, y: number, z: number): boolean;
+}
+
+// Result of VoronoiContext3D.relax, with one displacement entry per iteration.
+export interface RelaxResult {
+	iterations: number;
+	converged: boolean;
+	maxDisplacement: number[];
+	meanDisplacement: number[];
+}
+
+// Result of VoronoiContext3D.getStats, counted while statistics are enabled.
+// The times are in milliseconds; computeMs includes the time spent in walls,
+// also in JavaScript walls (jsWallMs).
+export interface ContextStats {
+	enabled: boolean;
+	particlesInserted: number;
+	cellsComputed: number;
+	cellsFailed: number;
+	jsWallCalls: number;
+	bytesEmitted: number;
+	insertMs: number;
+	computeMs: number;
+	jsWallMs: number;
+	extractMs: number;
+	packMs: number;
+	convertMs: number;
 }
 
 export interface VoronoiContext3D extends EmscriptenObject {
 	addPoint(id: number, x: number, y: number, z: number): void;
 	addPoints(ids: VectorInt, x: VectorDouble, y: VectorDouble, z: VectorDouble): void;
-	addWallPlane(x: number, y: number, z: number, d: number, id?: number): void;
-	addWallSphere(x: number, y: number, z: number, r: number, id?: number): void;
-	addWallCylinder(ax: number, ay: number, az: number, vx: number, vy: number, vz: number, r: number, id?: number): void;
-	addWallCone(ax: number, ay: number, az: number, vx: number, vy: number, vz: number, a: number, id?: number): void;
-	addWallJS(wall: any): void;
-	getCellsRaw(): any;
-	getCells(): any[];
-	getCellById(id: number): VoronoiCell3D;
+	addPointsFlat(ids: Int32Array, xyz: Float64Array): void;
+	addPointsSoA(ids: Int32Array, x: Float64Array, y: Float64Array, z: Float64Array): void;
+	movePoint(id: number, x: number, y: number, z: number): boolean;
+	removePoint(id: number): boolean;
+	addWallPlane(x: number, y: number, z: number, d: number, id?: number): number;
+	addWallPlanes(planes: Float64Array, id?: number): number;
+	addWallSphere(x: number, y: number, z: number, r: number, id?: number): number;
+	addWallCylinder(ax: number, ay: number, az: number, vx: number, vy: number, vz: number, r: number, id?: number): number;
+	addWallCone(ax: number, ay: number, az: number, vx: number, vy: number, vz: number, a: number, id?: number): number;
+	addWallJS(wall: any): number;
+	addWallJSBatched(wall: BatchedWall, id?: number): number;
+	addWallSDF(shape: SdfShape, id?: number): number;
+	removeWall(handle: number): boolean;
+	clearWalls(): void;
+	getCellsRaw(fields?: number): any;
+	getCells(fields?: number): any[];
+	getCellsFlat(fields?: number): VoronoiCellsFlat;
+	getCellById(id: number, fields?: number): any;
+	getCellsByIds(ids: Int32Array, fields?: number): VoronoiCellsFlat;
+	getNeighborGraph(withAreas?: boolean): NeighborGraph;
+	getRenderMesh(options?: RenderMeshOptions): RenderMesh;
+	getWireframe(): Wireframe;
+	locatePoints(xyz: Float64Array): Int32Array;
+	beginCompute(fields?: number): void;
+	computeChunk(maxCells: number, maxMillis?: number): VoronoiCellsFlat;
+	isDone(): boolean;
+	cancelCompute(): void;
 	relaxVoronoi(): any;
+	relax(iterations: number, tolerance?: number): RelaxResult;
+	setThreads(n: number): void;
+	getThreads(): number;
+	getGrid(): number[];
+	setSortedInsert(sorted: boolean): void;
+	setPrecision(bits: 32 | 64, relativeVertices?: boolean): void;
+	setStatsEnabled(enabled: boolean): void;
+	getStats(): ContextStats;
+	resetStats(): void;
+	clear(): void;
+}
+
+/**
+ * A context for particles with radii, which computes the radical (power)
+ * tessellation: the face between two particles lies where their squared
+ * distance minus their squared radius is equal. Points are added with radii,
+ * everything else works like in VoronoiContext3D, except that cells are
+ * computed on a single thread.
+ */
+export interface VoronoiContextPoly3D extends Omit<VoronoiContext3D, 'addPoint' | 'addPoints' | 'addPointsFlat' | 'addPointsSoA'> {
+	addPoint(id: number, x: number, y: number, z: number, r: number): void;
+	addPointsFlat(ids: Int32Array, xyz: Float64Array, radii: Float64Array): void;
+	addPointsSoA(ids: Int32Array, x: Float64Array, y: Float64Array, z: Float64Array, radii: Float64Array): void;
+}
+
+/**
+ * A container periodic along all axes, spanned by the box vectors (bx, 0, 0),
+ * (bxy, by, 0) and (bxz, byz, bz) from the origin, which allows triclinic boxes.
+ * Points outside of the box are moved into it by the periodicity.
+ */
+export interface VoronoiContextPeriodic3D extends EmscriptenObject {
+	addPoint(id: number, x: number, y: number, z: number): void;
+	addPointsFlat(ids: Int32Array, xyz: Float64Array): void;
+	getCells(fields?: number): any[];
+	getCellsFlat(fields?: number): VoronoiCellsFlat;
+	getCellById(id: number, fields?: number): any;
 	clear(): void;
 }
 
+// Options for loading the Voro++ module.
+export interface VoroOptions {
+	// Loads the multithreaded build if the environment provides shared memory,
+	// which browsers only allow on cross-origin isolated pages.
+	threads?: boolean;
+	// Loads the WebAssembly SIMD build if the engine supports it, on by default.
+	simd?: boolean;
+}
+
 // Define the shape of the Voro++ API.
 export interface VoroAPI {
+	threads: boolean;
+	simd: boolean;
 	VoronoiContext3D: new (...args: any[]) => VoronoiContext3D;
+	VoronoiContextPoly3D: new (...args: any[]) => VoronoiContextPoly3D;
+	VoronoiContextPeriodic3D: new (bx: number, bxy: number, by: number, bxz: number, byz: number, bz: number, nx: number, ny: number, nz: number) => VoronoiContextPeriodic3D;
 	VoronoiCell3D: new (...args: any[]) => VoronoiCell3D;
 	VectorInt: new () => VectorInt;
 	VectorDouble: new () => VectorDouble;
@@ -54,27 +260,302 @@ export interface VoroAPI {
 // Store the module instance.
 let voroModule: VoroAPI | null = null;
 
+// Whether the engine supports WebAssembly SIMD, by validating a module with a
+// single function that returns a v128 (i8x16.splat, i8x16.popcnt).
+function supportsSimd(): boolean
+{
+	return WebAssembly.validate(new Uint8Array([
+		0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0,
+		10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11
+	]));
+}
+
+// Instantiates a build variant, or returns null if it is not available.
+async function loadVariant(load: () => Promise<any>): Promise<any>
+{
+	try {
+		const variant = await load();
+		return await variant.default();
+	} catch (e) {
+		return null;
+	}
+}
+
+// Whether WebAssembly threads can be used in this environment.
+function supportsThreads(): boolean
+{
+	return typeof SharedArrayBuffer !== 'undefined' && (globalThis as any).crossOriginIsolated !== false;
+}
+
 /**
  * Initializes the Voro++ WebAssembly module.
  * This function must be called and awaited before using any other functionality.
+ * @param {VoroOptions} options Selects the build to load, only used by the first call.
  * @returns {Promise<VoroAPI>} A promise that resolves with the Voro++ API.
  */
-export async function initializeVoro(): Promise<VoroAPI>
+export async function initializeVoro(options: VoroOptions = {}): Promise<VoroAPI>
 {
 	// The API is already loaded.
 	if (voroModule)
 		return voroModule;
 	
-	// Create the module instance.
-	const Module = await createVoroModule();
+	// Create the module instance, preferring the multithreaded build if requested,
+	// then the SIMD build and finally falling back to the plain build.
+	let Module: any = null;
+	let threads = false;
+	let simd = false;
+	if (options.threads && supportsThreads())
+	{
+		// @ts-ignore: This file is generated during the build process.
+		Module = await loadVariant(() => import('./REPLACE_ME_mt.js'));
+		threads = Module !== null;
+	}
+	if (!Module && options.simd !== false && supportsSimd())
+	{
+		// @ts-ignore: This file is generated during the build process.
+		Module = await loadVariant(() => import('./REPLACE_ME_simd.js'));
+		simd = Module !== null;
+	}
+	if (!Module)
+		Module = await createVoroModule();
 
 	// The API is now ready to be used.
 	voroModule = {
+		threads: threads,
+		simd: simd,
 		// This is where classes/functions are exposed.
 		VoronoiContext3D: Module.VoronoiContext3D,
+		VoronoiContextPoly3D: Module.VoronoiContextPoly3D,
+		VoronoiContextPeriodic3D: Module.VoronoiContextPeriodic3D,
 		VoronoiCell3D: Module.VoronoiCell3D,
         VectorInt: Module.VectorInt,
         VectorDouble: Module.VectorDouble,
 	};
 	return voroModule;
 }
+
+/**
+ * Container of a tessellation computed by a worker pool. The bounds are
+ * [xmin, xmax, ymin, ymax, zmin, zmax], without grid the blocks are sized for
+ * the number of points. The ids default to the index of each point, and radii
+ * compute the radical tessellation of VoronoiContextPoly3D.
+ */
+export interface TessellateOptions {
+	bounds: number[];
+	ids?: Int32Array;
+	radii?: Float64Array;
+	grid?: number[];
+	periodic?: boolean[];
+	fields?: number;
+}
+
+/**
+ * Workers which tessellate independent containers in parallel, off the calling
+ * thread. The results own their arrays, which are transferred from the workers.
+ * Crashed workers reject their container and are replaced.
+ */
+export interface VoroWorkerPool {
+	size: number;
+	tessellate(points: Float64Array, options: TessellateOptions): Promise<VoronoiCellsFlat>;
+	terminate(): void;
+}
+
+// A worker of the pool, wrapping either a Web Worker or a Node worker thread.
+// A worker that crashed is terminated before onCrash is called.
+interface PoolWorker {
+	handler: (message: any) => void;
+	onCrash: (error: Error) => void;
+	post(message: any): void;
+	terminate(): void;
+}
+
+// A tessellation waiting for a free worker.
+interface PoolTask {
+	points: Float64Array;
+	options: TessellateOptions;
+	resolve: (result: VoronoiCellsFlat) => void;
+	reject: (error: Error) => void;
+}
+
+// Whether this runs in Node rather than a browser.
+function isNode(): boolean
+{
+	return typeof (globalThis as any).process?.versions?.node === 'string';
+}
+
+// Imports a Node built-in module, hidden from bundlers of the browser build.
+function importNode(name: string): Promise<any>
+{
+	return import(/* @vite-ignore */ 'node:' + name);
+}
+
+// Compiles the WebAssembly module of the plain build once for all workers.
+async function compileModule(url: URL): Promise<WebAssembly.Module>
+{
+	if (isNode())
+	{
+		const fs = await importNode('fs/promises');
+		return WebAssembly.compile(await fs.readFile(url));
+	}
+	const response = await fetch(url);
+	return WebAssembly.compile(await response.arrayBuffer());
+}
+
+// Starts a worker and waits until it instantiated the compiled module.
+async function startWorker(url: URL, module: WebAssembly.Module): Promise<PoolWorker>
+{
+	let worker: PoolWorker;
+	let terminated = false;
+	// Uncaught errors and exits leave the worker in an unknown state, as do
+	// errors the worker reports as fatal, so it is not used any further.
+	const crash = (message: string) => {
+		if (terminated)
+			return;
+		worker.terminate();
+		worker.onCrash(new Error(message));
+	};
+	const receive = (message: any) => message.fatal ? crash(message.error) : worker.handler(message);
+	if (isNode())
+	{
+		const { Worker } = await importNode('worker_threads');
+		const thread = new Worker(url);
+		worker = {
+			handler: () => {},
+			onCrash: () => {},
+			post: (message: any) => thread.postMessage(message),
+			terminate: () => { terminated = true; thread.terminate(); }
+		};
+		thread.on('message', receive);
+		thread.on('error', (e: Error) => crash(e.message));
+		thread.on('exit', (code: number) => crash(`The worker exited with code ${code}`));
+	}
+	else
+	{
+		const thread = new Worker(url, { type: 'module' });
+		worker = {
+			handler: () => {},
+			onCrash: () => {},
+			post: (message: any) => thread.postMessage(message),
+			terminate: () => { terminated = true; thread.terminate(); }
+		};
+		thread.onmessage = (e: MessageEvent) => receive(e.data);
+		thread.onerror = (e: ErrorEvent) => crash(e.message);
+	}
+	try {
+		await new Promise<void>((resolve, reject) => {
+			worker.handler = (message: any) => message.error ? reject(new Error(message.error)) : resolve();
+			worker.onCrash = reject;
+			worker.post({ type: 'init', module: module });
+		});
+	} catch (e) {
+		worker.terminate();
+		throw e;
+	}
+	return worker;
+}
+
+/**
+ * Creates a pool of workers which tessellate containers in parallel. The
+ * WebAssembly module is compiled once and shared with all workers, which use
+ * the plain build.
+ * @param {number} n The number of workers, by default the number of cores.
+ * @returns {Promise<VoroWorkerPool>} A promise that resolves with the pool once all workers are ready.
+ */
+export async function createVoroWorkerPool(n: number = (globalThis as any).navigator?.hardwareConcurrency ?? 4): Promise<VoroWorkerPool>
+{
+	const module = await compileModule(new URL('./REPLACE_ME.wasm', import.meta.url));
+	const workerUrl = new URL('./REPLACE_ME_worker.js', import.meta.url);
+	const workers = await Promise.all(Array.from({ length: Math.max(1, n) }, () => startWorker(workerUrl, module)));
+
+	// Every worker tessellates one container at a time, further ones are queued.
+	const idle: PoolWorker[] = [];
+	const queue: PoolTask[] = [];
+	const running = new Map<PoolWorker, PoolTask>();
+	let starting = 0;
+	let terminated = false;
+	function release(worker: PoolWorker)
+	{
+		idle.push(worker);
+		worker.onCrash = () => {
+			idle.splice(idle.indexOf(worker), 1);
+			replace(worker);
+		};
+	}
+	function dispatch()
+	{
+		while (idle.length > 0 && queue.length > 0)
+		{
+			const worker = idle.pop()!;
+			const task = queue.shift()!;
+			running.set(worker, task);
+			worker.handler = (message: any) => {
+				running.delete(worker);
+				release(worker);
+				if (message.error)
+					task.reject(new Error(message.error));
+				else
+					task.resolve(message.result);
+				dispatch();
+			};
+			worker.onCrash = (error: Error) => {
+				running.delete(worker);
+				task.reject(error);
+				replace(worker);
+			};
+			worker.post({ type: 'tessellate', points: task.points, options: task.options });
+		}
+	}
+	// Starts a new worker in place of a crashed one. The queued containers are
+	// rejected once no worker is left.
+	function replace(worker: PoolWorker)
+	{
+		workers.splice(workers.indexOf(worker), 1);
+		if (terminated)
+			return;
+		starting++;
+		startWorker(workerUrl, module).then((started) => {
+			starting--;
+			if (terminated)
+			{
+				started.terminate();
+				return;
+			}
+			workers.push(started);
+			release(started);
+			dispatch();
+		}, () => {
+			starting--;
+			if (workers.length === 0 && starting === 0)
+				for (const task of queue.splice(0))
+					task.reject(new Error('All workers of the pool crashed'));
+		});
+	}
+	workers.forEach(release);
+
+	return {
+		get size() {
+			return workers.length;
+		},
+		tessellate(points: Float64Array, options: TessellateOptions): Promise<VoronoiCellsFlat> {
+			return new Promise((resolve, reject) => {
+				if (terminated || (workers.length === 0 && starting === 0))
+				{
+					reject(new Error(terminated ? 'The worker pool was terminated' : 'All workers of the pool crashed'));
+					return;
+				}
+				queue.push({ points, options, resolve, reject });
+				dispatch();
+			});
+		},
+		terminate() {
+			terminated = true;
+			// a terminated worker neither replies nor crashes, so the containers
+			// it tessellates are rejected here
+			for (const worker of workers)
+				worker.terminate();
+			for (const task of [...running.values(), ...queue.splice(0)])
+				task.reject(new Error('The worker pool was terminated'));
+			running.clear();
+		}
+	};
+}
@@ -0,0 +1,953 @@
+/**
+ * The computational core of the voro-js wrapper, free of Emscripten bindings.
+ *
+ * Holds the output structures, the extraction of cells into them and the
+ * spatially sorted bulk insertion, such that they can be compiled natively,
+ * e.g. by the benchmark in bench/.
+*/
+
+#ifndef VOROJS_CORE_HH
+#define VOROJS_CORE_HH
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <chrono>
+#endif
+#include "../voro++/src/voro++.hh"
+#include "voro_kernels.hh"
+
+
+/** \brief Helper structure to represent a 3d point for easy JavaScript interaction.
+ */
+struct Point3D
+{
+	double x;
+	double y;
+	double z;
+};
+
+/** \brief Helper structure to represent a Voronoi cell's properties for JavaScript.
+ */
+struct VoronoiCell
+{
+	int id;
+	Point3D position;
+	double volume;
+	std::vector<Point3D> vertices;
+	std::vector<std::vector<int>> edges;
+	std::vector<std::vector<int>> faces;
+	std::vector<int> neighbors;
+};
+
+/** \brief Helper structure to locate a particle inside the voro++ container,
+ * by its block index ijk and its slot q within that block.
+ */
+struct ParticleLocation
+{
+	int ijk;
+	int q;
+};
+
+/** \brief Bit flags selecting the fields of a cell to extract. Fields which are
+ * not requested are neither computed nor copied and stay empty in the output.
+ */
+enum CellField
+{
+	CELL_VOLUME = 1,
+	CELL_VERTICES = 2,
+	CELL_FACES = 4,
+	CELL_EDGES = 8,
+	CELL_NEIGHBORS = 16,
+	CELL_ALL = 31
+};
+
+/** \brief Helper structure holding a whole tessellation in flat arrays.
+ *
+ * All cells are stored back to back so that JavaScript can read them through
+ * typed array views on the WebAssembly heap without creating any objects.
+ * Each *_offsets array has one entry more than the items it indexes, such that
+ * the entries of item i are found in [offsets[i], offsets[i+1]).
+ */
+struct VoronoiCellsFlat
+{
+	// Per cell: id, position (x, y, z), volume and centroid (x, y, z).
+	std::vector<int> ids;
+	std::vector<double> positions;
+	std::vector<double> volumes;
+	std::vector<double> centroids;
+	// Global vertex coordinates [x1, y1, z1, ...], indexed per cell in vertices.
+	std::vector<double> vertices;
+	std::vector<int> vertex_offsets;
+	// Faces of a cell, indexed per cell in faces; neighbors has one entry per face.
+	std::vector<int> face_offsets;
+	std::vector<int> neighbors;
+	// Vertex numbers (local to the cell) of each face, indexed per face.
+	std::vector<int> face_vertices;
+	std::vector<int> face_vertex_offsets;
+	// Unique edges as vertex number pairs (local to the cell), indexed per cell in edges.
+	std::vector<int> edges;
+	std::vector<int> edge_offsets;
+
+	// Appends all cells of another flat tessellation, shifting its offsets.
+	void append(const VoronoiCellsFlat& other)
+	{
+		append_offsets(vertex_offsets, other.vertex_offsets);
+		append_offsets(face_offsets, other.face_offsets);
+		append_offsets(face_vertex_offsets, other.face_vertex_offsets);
+		append_offsets(edge_offsets, other.edge_offsets);
+		ids.insert(ids.end(), other.ids.begin(), other.ids.end());
+		positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+		volumes.insert(volumes.end(), other.volumes.begin(), other.volumes.end());
+		centroids.insert(centroids.end(), other.centroids.begin(), other.centroids.end());
+		vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+		neighbors.insert(neighbors.end(), other.neighbors.begin(), other.neighbors.end());
+		face_vertices.insert(face_vertices.end(), other.face_vertices.begin(), other.face_vertices.end());
+		edges.insert(edges.end(), other.edges.begin(), other.edges.end());
+	}
+
+	// Size of all arrays in bytes.
+	size_t bytes() const
+	{
+		return sizeof(int) * (ids.size() + vertex_offsets.size() + face_offsets.size() + neighbors.size()
+				+ face_vertices.size() + face_vertex_offsets.size() + edges.size() + edge_offsets.size())
+			+ sizeof(double) * (positions.size() + volumes.size() + centroids.size() + vertices.size());
+	}
+
+	// Empties all arrays but keeps their capacity for the next tessellation.
+	void clear()
+	{
+		ids.clear();
+		positions.clear();
+		volumes.clear();
+		centroids.clear();
+		vertices.clear();
+		vertex_offsets.assign(1, 0);
+		face_offsets.assign(1, 0);
+		neighbors.clear();
+		face_vertices.clear();
+		face_vertex_offsets.assign(1, 0);
+		edges.clear();
+		edge_offsets.assign(1, 0);
+	}
+
+private:
+	static void append_offsets(std::vector<int>& dst, const std::vector<int>& src)
+	{
+		int base = dst.back();
+		for (size_t i = 1; i < src.size(); ++i)
+			dst.push_back(base + src[i]);
+	}
+};
+
+/** \brief The floating point arrays of a flat tessellation in single precision,
+ * optionally with the vertices relative to the position of their cell's
+ * particle, which keeps more of their precision in large containers.
+ */
+struct VoronoiCellsFlat32
+{
+	std::vector<float> positions;
+	std::vector<float> volumes;
+	std::vector<float> centroids;
+	std::vector<float> vertices;
+
+	// Converts the arrays of a flat tessellation.
+	void assign(const VoronoiCellsFlat& f, bool relative_vertices)
+	{
+		clear();
+		append_from(f, relative_vertices);
+	}
+
+	// Converts the cells of a flat tessellation that were appended to it since
+	// the last conversion, which was of the same tessellation.
+	void append_from(const VoronoiCellsFlat& f, bool relative_vertices)
+	{
+		size_t start = cells();
+		positions.insert(positions.end(), f.positions.begin() + 3 * start, f.positions.end());
+		volumes.insert(volumes.end(), f.volumes.begin() + volumes.size(), f.volumes.end());
+		centroids.insert(centroids.end(), f.centroids.begin() + centroids.size(), f.centroids.end());
+		vertices.resize(f.vertices.size());
+		for (size_t i = start; i < f.ids.size(); ++i)
+		{
+			const double* o = f.positions.data() + 3 * i;
+			for (int k = 3 * f.vertex_offsets[i]; k < 3 * f.vertex_offsets[i + 1]; k += 3)
+				for (int a = 0; a < 3; ++a)
+					vertices[k + a] = static_cast<float>(relative_vertices ? f.vertices[k + a] - o[a] : f.vertices[k + a]);
+		}
+	}
+
+	// Number of converted cells, each of which has a position.
+	size_t cells() const
+	{
+		return positions.size() / 3;
+	}
+
+	void clear()
+	{
+		positions.clear();
+		volumes.clear();
+		centroids.clear();
+		vertices.clear();
+	}
+
+	// Size of all arrays in bytes.
+	size_t bytes() const
+	{
+		return sizeof(float) * (positions.size() + volumes.size() + centroids.size() + vertices.size());
+	}
+};
+
+/** \brief Helper structure holding the neighbor graph of a tessellation in
+ * compressed sparse row form.
+ *
+ * Row i belongs to the particle ids[i], its neighbors are found at
+ * [offsets[i], offsets[i+1]) in neighbors and, if requested, the areas of the
+ * shared faces at the same positions in areas. Contacts with walls or the
+ * container boundary, which voro++ reports as negative ids, are kept apart in
+ * walls and wall_areas, indexed by wall_offsets.
+ */
+struct NeighborGraph
+{
+	std::vector<int> ids;
+	std::vector<int> offsets;
+	std::vector<int> neighbors;
+	std::vector<double> areas;
+	std::vector<int> wall_offsets;
+	std::vector<int> walls;
+	std::vector<double> wall_areas;
+
+	// Appends all rows of another graph, shifting its offsets.
+	void append(const NeighborGraph& other)
+	{
+		append_offsets(offsets, other.offsets);
+		append_offsets(wall_offsets, other.wall_offsets);
+		ids.insert(ids.end(), other.ids.begin(), other.ids.end());
+		neighbors.insert(neighbors.end(), other.neighbors.begin(), other.neighbors.end());
+		areas.insert(areas.end(), other.areas.begin(), other.areas.end());
+		walls.insert(walls.end(), other.walls.begin(), other.walls.end());
+		wall_areas.insert(wall_areas.end(), other.wall_areas.begin(), other.wall_areas.end());
+	}
+
+	// Size of all arrays in bytes.
+	size_t bytes() const
+	{
+		return sizeof(int) * (ids.size() + offsets.size() + neighbors.size() + wall_offsets.size() + walls.size())
+			+ sizeof(double) * (areas.size() + wall_areas.size());
+	}
+
+	// Empties all arrays but keeps their capacity for the next graph.
+	void clear()
+	{
+		ids.clear();
+		offsets.assign(1, 0);
+		neighbors.clear();
+		areas.clear();
+		wall_offsets.assign(1, 0);
+		walls.clear();
+		wall_areas.clear();
+	}
+
+private:
+	static void append_offsets(std::vector<int>& dst, const std::vector<int>& src)
+	{
+		int base = dst.back();
+		for (size_t i = 1; i < src.size(); ++i)
+			dst.push_back(base + src[i]);
+	}
+};
+
+/** \brief Helper structure holding the triangulated surfaces of cells, ready
+ * to be uploaded to the GPU.
+ *
+ * The vertices are interleaved as [px, py, pz, nx, ny, nz] in single precision
+ * and the triangles index them globally. The vertices of cell i are found at
+ * [vertex_offsets[i], vertex_offsets[i+1]) and its triangles, as a draw range
+ * of the index buffer, at [index_offsets[i], index_offsets[i+1]).
+ */
+struct RenderMesh
+{
+	std::vector<int> ids;
+	std::vector<double> positions;
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<int> vertex_offsets;
+	std::vector<int> index_offsets;
+
+	// Appends all cells of another mesh, shifting its offsets and indices.
+	void append(const RenderMesh& other)
+	{
+		uint32_t base = static_cast<uint32_t>(vertices.size() / 6);
+		append_offsets(vertex_offsets, other.vertex_offsets);
+		append_offsets(index_offsets, other.index_offsets);
+		ids.insert(ids.end(), other.ids.begin(), other.ids.end());
+		positions.insert(positions.end(), other.positions.begin(), other.positions.end());
+		vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+		for (uint32_t i : other.indices)
+			indices.push_back(base + i);
+	}
+
+	// Size of all arrays in bytes.
+	size_t bytes() const
+	{
+		return sizeof(int) * (ids.size() + vertex_offsets.size() + index_offsets.size())
+			+ sizeof(double) * positions.size() + sizeof(float) * vertices.size() + sizeof(uint32_t) * indices.size();
+	}
+
+	// Empties all arrays but keeps their capacity for the next mesh.
+	void clear()
+	{
+		ids.clear();
+		positions.clear();
+		vertices.clear();
+		indices.clear();
+		vertex_offsets.assign(1, 0);
+		index_offsets.assign(1, 0);
+	}
+
+private:
+	static void append_offsets(std::vector<int>& dst, const std::vector<int>& src)
+	{
+		int base = dst.back();
+		for (size_t i = 1; i < src.size(); ++i)
+			dst.push_back(base + src[i]);
+	}
+};
+
+/** \brief Appends the unique edges of a cell as vertex number pairs [a1, b1, a2, b2, ...].
+ * Every edge is stored twice in the vertex-edge table of voro++, once at each of
+ * its vertices, so it is emitted from its lower vertex only (a < b).
+ */
+template<class v_cell>
+void append_edges(v_cell& c, std::vector<int>& edges)
+{
+	for (int i = 0; i < c.p; ++i)
+		for (int j = 0; j < c.nu[i]; ++j)
+			if (i < c.ed[i][j])
+			{
+				edges.push_back(i);
+				edges.push_back(c.ed[i][j]);
+			}
+}
+
+/** \brief Converts flat edge pairs to the vector<vector<int>> format of VoronoiCell,
+ * clearing the flat pairs for their next use.
+ */
+inline void edges_to_pairs(std::vector<int>& edges, std::vector<std::vector<int>>& pairs)
+{
+	pairs.reserve(pairs.size() + edges.size() / 2);
+	for (size_t i = 0; i < edges.size(); i += 2)
+		pairs.push_back({edges[i], edges[i + 1]});
+	edges.clear();
+}
+
+/** \brief Scratch buffers for extracting a cell, one set per computing thread.
+ */
+struct ExtractScratch
+{
+	double volume;
+	double centroid[3];
+	std::vector<double> vertices;
+	std::vector<int> face_vertices;
+	std::vector<int> neighbors;
+	std::vector<int> edges;
+	std::vector<double> face_areas;
+	std::vector<double> vertex_normals;
+};
+
+// Only cells with neighbor information know the particles across their faces.
+inline void cell_neighbors(voro::voronoicell_neighbor& c, std::vector<int>& neighbors)
+{
+	c.neighbors(neighbors);
+}
+
+inline void cell_neighbors(voro::voronoicell&, std::vector<int>& neighbors)
+{
+	neighbors.clear();
+}
+
+/** \brief Extracts the requested fields of a cell into the scratch buffers.
+ * Fields which are not requested are left empty, the volume and centroid are
+ * zero unless CELL_VOLUME is requested.
+ * \param[in] c the computed cell.
+ * \param[in] (x,y,z) the position of its particle.
+ * \param[in] fields the CellField flags to extract.
+ * \param[out] s the global vertices, the faces in voro++ format
+ *                 [f1#, f1_v1, f1v2, ... fn#, fn_v1, ...], the edge pairs and
+ *                 the neighbors of the cell.
+ */
+template<class v_cell>
+void extract_cell_data(v_cell& c, double x, double y, double z, int fields, ExtractScratch& s)
+{
+	s.volume = 0;
+	s.centroid[0] = s.centroid[1] = s.centroid[2] = 0;
+	s.vertices.clear();
+	s.face_vertices.clear();
+	s.edges.clear();
+	s.neighbors.clear();
+
+	// The volume needs both the local vertices and the faces.
+	if (fields & (CELL_VOLUME | CELL_VERTICES))
+		c.vertices(s.vertices);
+	if (fields & (CELL_VOLUME | CELL_FACES))
+		c.face_vertices(s.face_vertices);
+	if (fields & CELL_VOLUME)
+	{
+		double cx, cy, cz;
+		s.volume = cell_volume_centroid(s.vertices.data(), s.face_vertices.data(), s.face_vertices.size(), cx, cy, cz);
+		s.centroid[0] = x + cx;
+		s.centroid[1] = y + cy;
+		s.centroid[2] = z + cz;
+	}
+	if (fields & CELL_VERTICES)
+		translate_vertices(s.vertices.data(), s.vertices.size() / 3, x, y, z, s.vertices.data());
+	else
+		s.vertices.clear();
+	if (!(fields & CELL_FACES))
+		s.face_vertices.clear();
+
+	if (fields & CELL_EDGES)
+		append_edges(c, s.edges);
+	if (fields & CELL_NEIGHBORS)
+		cell_neighbors(c, s.neighbors);
+}
+
+/** \brief Appends a cell extracted by extract_cell_data to flat output buffers.
+ */
+inline void append_cell_flat(int id, double x, double y, double z, int fields, const ExtractScratch& s, VoronoiCellsFlat& out)
+{
+	out.ids.push_back(id);
+	out.positions.insert(out.positions.end(), {x, y, z});
+	if (fields & CELL_VOLUME)
+	{
+		out.volumes.push_back(s.volume);
+		out.centroids.insert(out.centroids.end(), s.centroid, s.centroid + 3);
+	}
+
+	out.vertices.insert(out.vertices.end(), s.vertices.begin(), s.vertices.end());
+	out.vertex_offsets.push_back(static_cast<int>(out.vertices.size() / 3));
+
+	// Drop the vertex counts of the faces and record them as offsets instead.
+	int n_faces = 0;
+	for (size_t i = 0; i < s.face_vertices.size(); i += s.face_vertices[i] + 1, ++n_faces)
+	{
+		int fv_cnt = s.face_vertices[i];
+		out.face_vertices.insert(out.face_vertices.end(), s.face_vertices.begin() + i + 1, s.face_vertices.begin() + i + 1 + fv_cnt);
+		out.face_vertex_offsets.push_back(static_cast<int>(out.face_vertices.size()));
+	}
+
+	// One neighbor per face, in the same order as the faces.
+	out.neighbors.insert(out.neighbors.end(), s.neighbors.begin(), s.neighbors.end());
+	if (fields & CELL_NEIGHBORS)
+		n_faces = static_cast<int>(s.neighbors.size());
+	out.face_offsets.push_back(out.face_offsets.back() + n_faces);
+
+	out.edges.insert(out.edges.end(), s.edges.begin(), s.edges.end());
+	out.edge_offsets.push_back(static_cast<int>(out.edges.size() / 2));
+}
+
+/** \brief Appends the row of a computed cell to a neighbor graph, without
+ * extracting any of its geometry but the face areas, if requested.
+ */
+inline void append_cell_graph(int id, voro::voronoicell_neighbor& c, bool with_areas, ExtractScratch& s, NeighborGraph& g)
+{
+	c.neighbors(s.neighbors);
+	if (with_areas)
+		c.face_areas(s.face_areas);
+	g.ids.push_back(id);
+	for (size_t f = 0; f < s.neighbors.size(); ++f)
+	{
+		bool wall = s.neighbors[f] < 0;
+		(wall ? g.walls : g.neighbors).push_back(s.neighbors[f]);
+		if (with_areas)
+			(wall ? g.wall_areas : g.areas).push_back(s.face_areas[f]);
+	}
+	g.offsets.push_back(static_cast<int>(g.neighbors.size()));
+	g.wall_offsets.push_back(static_cast<int>(g.walls.size()));
+}
+
+/** \brief Appends the triangulated surface of a computed cell to a render mesh.
+ * \param[in] (x,y,z) the position of its particle.
+ * \param[in] flat_normals whether every face gets its own vertices with the
+ *                         face normal, or the vertices are shared by the faces
+ *                         of the cell with their area weighted mean normal.
+ * \param[in] shrink the factor to scale the cell by around its centroid.
+ */
+template<class v_cell>
+void append_cell_mesh(int id, v_cell& c, double x, double y, double z, bool flat_normals, double shrink, ExtractScratch& s, RenderMesh& m)
+{
+	c.vertices(s.vertices);
+	c.face_vertices(s.face_vertices);
+	// The centroid lies inside of the convex cell, which orients the faces
+	// outwards, also in a radical tessellation where the particle may not.
+	double cx, cy, cz;
+	cell_volume_centroid(s.vertices.data(), s.face_vertices.data(), s.face_vertices.size(), cx, cy, cz);
+	m.ids.push_back(id);
+	m.positions.insert(m.positions.end(), {x, y, z});
+
+	const uint32_t base = static_cast<uint32_t>(m.vertices.size() / 6);
+	const double* v = s.vertices.data();
+	auto push_vertex = [&](int k, const double* n) {
+		const double* p = v + 3 * k;
+		m.vertices.insert(m.vertices.end(), {
+			static_cast<float>(x + cx + shrink * (p[0] - cx)),
+			static_cast<float>(y + cy + shrink * (p[1] - cy)),
+			static_cast<float>(z + cz + shrink * (p[2] - cz)),
+			static_cast<float>(n[0]), static_cast<float>(n[1]), static_cast<float>(n[2])});
+	};
+	if (!flat_normals)
+		s.vertex_normals.assign(s.vertices.size(), 0);
+
+	for (size_t i = 0; i < s.face_vertices.size(); i += s.face_vertices[i] + 1)
+	{
+		const int n = s.face_vertices[i];
+		const int* face = s.face_vertices.data() + i + 1;
+		double normal[3];
+		double area = face_area_normal(v, face, n, normal);
+		const double* p0 = v + 3 * face[0];
+		bool flip = normal[0] * (p0[0] - cx) + normal[1] * (p0[1] - cy) + normal[2] * (p0[2] - cz) < 0;
+		if (flip)
+			for (int a = 0; a < 3; ++a)
+				normal[a] = -normal[a];
+
+		// Fan triangles around the first vertex of the face, counterclockwise
+		// seen from outside.
+		uint32_t first = flat_normals ? static_cast<uint32_t>(m.vertices.size() / 6) : 0;
+		for (int j = 1; j + 1 < n; ++j)
+		{
+			uint32_t a = flat_normals ? first : base + face[0];
+			uint32_t b = flat_normals ? first + j : base + face[j];
+			uint32_t d = flat_normals ? first + j + 1 : base + face[j + 1];
+			m.indices.insert(m.indices.end(), {a, flip ? d : b, flip ? b : d});
+		}
+		if (flat_normals)
+		{
+			for (int j = 0; j < n; ++j)
+				push_vertex(face[j], normal);
+		}
+		else
+		{
+			for (int j = 0; j < n; ++j)
+				for (int a = 0; a < 3; ++a)
+					s.vertex_normals[3 * face[j] + a] += area * normal[a];
+		}
+	}
+
+	if (!flat_normals)
+	{
+		for (size_t k = 0; k < s.vertices.size() / 3; ++k)
+		{
+			double* n = s.vertex_normals.data() + 3 * k;
+			double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (len > 0)
+				for (int a = 0; a < 3; ++a)
+					n[a] /= len;
+			push_vertex(static_cast<int>(k), n);
+		}
+	}
+	m.vertex_offsets.push_back(static_cast<int>(m.vertices.size() / 6));
+	m.index_offsets.push_back(static_cast<int>(m.indices.size()));
+}
+
+/** \brief Converts a cell extracted by extract_cell_data to a VoronoiCell.
+ */
+inline void scratch_to_cell(int id, double x, double y, double z, ExtractScratch& s, VoronoiCell& cell)
+{
+	cell.id = id;
+	cell.position = {x, y, z};
+	cell.volume = s.volume;
+
+	// Convert the vertices from [x1, y1, z1, ...] to vector<Point3D>.
+	cell.vertices.reserve(s.vertices.size() / 3);
+	for (size_t i = 0; i < s.vertices.size(); i += 3)
+		cell.vertices.push_back({s.vertices[i], s.vertices[i+1], s.vertices[i+2]});
+
+	// Split the faces [f1#, f1_v1, f1v2, ... fn#, fn_v1, ...] into one vector
+	// of vertex numbers per face.
+	for (size_t i = 0; i < s.face_vertices.size(); i += s.face_vertices[i] + 1)
+		cell.faces.emplace_back(s.face_vertices.begin() + i + 1, s.face_vertices.begin() + i + 1 + s.face_vertices[i]);
+
+	edges_to_pairs(s.edges, cell.edges);
+	cell.neighbors = s.neighbors;
+}
+
+/** \brief Builds the wireframe of a tessellation with every geometric edge once.
+ *
+ * Neighboring cells compute their shared vertices separately, so the global
+ * vertices are identified by hashing their position snapped to a grid with the
+ * given spacing, which is far above the rounding differences of voro++ and far
+ * below the distances of distinct vertices.
+ */
+class WireframeBuilder
+{
+public:
+	// segment end points [x1, y1, z1, x2, y2, z2, ...]
+	std::vector<float> segments;
+	
+	// emits the edges of all cells in f, which needs their vertices and edges
+	void build(const VoronoiCellsFlat& f, double spacing)
+	{
+		segments.clear();
+		vertex_ids.clear();
+		edge_keys.clear();
+		const double inv = 1 / spacing;
+		for (size_t i = 0; i < f.ids.size(); ++i)
+		{
+			const double* v = f.vertices.data() + 3 * f.vertex_offsets[i];
+			local_ids.resize(f.vertex_offsets[i + 1] - f.vertex_offsets[i]);
+			for (size_t k = 0; k < local_ids.size(); ++k)
+			{
+				const double* p = v + 3 * k;
+				GridKey key = {std::llround(p[0] * inv), std::llround(p[1] * inv), std::llround(p[2] * inv)};
+				local_ids[k] = vertex_ids.emplace(key, static_cast<uint32_t>(vertex_ids.size())).first->second;
+			}
+			for (int e = f.edge_offsets[i]; e < f.edge_offsets[i + 1]; ++e)
+			{
+				int a = f.edges[2 * e], b = f.edges[2 * e + 1];
+				uint64_t ga = local_ids[a], gb = local_ids[b];
+				if (ga == gb || !edge_keys.insert(std::min(ga, gb) << 32 | std::max(ga, gb)).second)
+					continue;
+				segments.insert(segments.end(), {
+					static_cast<float>(v[3 * a]), static_cast<float>(v[3 * a + 1]), static_cast<float>(v[3 * a + 2]),
+					static_cast<float>(v[3 * b]), static_cast<float>(v[3 * b + 1]), static_cast<float>(v[3 * b + 2])});
+			}
+		}
+	}
+
+private:
+	struct GridKey
+	{
+		long long x, y, z;
+		bool operator==(const GridKey& o) const { return x == o.x && y == o.y && z == o.z; }
+	};
+	struct GridKeyHash
+	{
+		size_t operator()(const GridKey& k) const
+		{
+			uint64_t h = static_cast<uint64_t>(k.x) * 0x9e3779b97f4a7c15ULL;
+			h ^= static_cast<uint64_t>(k.y) * 0xc2b2ae3d27d4eb4fULL + (h << 6) + (h >> 2);
+			h ^= static_cast<uint64_t>(k.z) * 0x165667b19e3779f9ULL + (h << 6) + (h >> 2);
+			return static_cast<size_t>(h);
+		}
+	};
+	std::unordered_map<GridKey, uint32_t, GridKeyHash> vertex_ids;
+	std::unordered_set<uint64_t> edge_keys;
+	std::vector<uint32_t> local_ids;
+};
+
+// Milliseconds of a monotonic clock, in WebAssembly that of the host.
+inline double now_ms()
+{
+#ifdef __EMSCRIPTEN__
+	return emscripten_get_now();
+#else
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/** \brief Counters and timers of the work done by a context, collected while
+ * statistics are enabled. The times are in milliseconds; compute_ms includes
+ * the time spent in walls, also in JavaScript walls.
+ */
+struct ContextStats
+{
+	uint64_t particles_inserted = 0;
+	uint64_t cells_computed = 0;
+	uint64_t cells_failed = 0;
+	uint64_t js_wall_calls = 0;
+	uint64_t bytes_emitted = 0;
+	double insert_ms = 0;
+	double compute_ms = 0;
+	double js_wall_ms = 0;
+	double extract_ms = 0;
+	double pack_ms = 0;
+	double convert_ms = 0;
+	
+	void add(const ContextStats& o)
+	{
+		particles_inserted += o.particles_inserted;
+		cells_computed += o.cells_computed;
+		cells_failed += o.cells_failed;
+		js_wall_calls += o.js_wall_calls;
+		bytes_emitted += o.bytes_emitted;
+		insert_ms += o.insert_ms;
+		compute_ms += o.compute_ms;
+		js_wall_ms += o.js_wall_ms;
+		extract_ms += o.extract_ms;
+		pack_ms += o.pack_ms;
+		convert_ms += o.convert_ms;
+	}
+};
+
+/** \brief Adds the time until it goes out of scope to a timer, unless the
+ * timer is null, in which case it does not read the clock at all.
+ */
+class PhaseTimer
+{
+public:
+	explicit PhaseTimer(double* timer_) : timer(timer_), start(timer_ ? now_ms() : 0) {}
+	~PhaseTimer()
+	{
+		if (timer)
+			*timer += now_ms() - start;
+	}
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+	double* timer;
+	double start;
+};
+
+/** \brief Output and scratch buffers of a single thread computing cells, and
+ * the statistics it collected since they were last merged.
+ */
+struct ComputeWorker
+{
+	VoronoiCellsFlat flat;
+	std::vector<VoronoiCell> cells;
+	std::vector<bool> computed;
+	ExtractScratch scratch;
+	NeighborGraph graph;
+	RenderMesh mesh;
+	ContextStats stats;
+};
+
+/** \brief Finds the block of a position and its cell on an 8x8x8 grid within
+ * the block, moving the position into the container along periodic axes like
+ * put does.
+ * \return false if the position lies outside of the container.
+ */
+template<class c_class>
+bool locate_block(const c_class& c, double pos[3], int block[3], int sub[3])
+{
+	const double lo[3] = {c.ax, c.ay, c.az}, hi[3] = {c.bx, c.by, c.bz}, sp[3] = {c.xsp, c.ysp, c.zsp};
+	const int n[3] = {c.nx, c.ny, c.nz};
+	const bool periodic[3] = {c.xperiodic, c.yperiodic, c.zperiodic};
+	for (int a = 0; a < 3; ++a)
+	{
+		double f = (pos[a] - lo[a]) * sp[a];
+		int b = static_cast<int>(std::floor(f));
+		if (b < 0 || b >= n[a])
+		{
+			if (!periodic[a])
+				return false;
+			// number of periodic images to shift by, rounded down
+			int shift = b >= 0 ? b / n[a] : -((n[a] - 1 - b) / n[a]);
+			pos[a] -= shift * (hi[a] - lo[a]);
+			b -= shift * n[a];
+			f -= shift * n[a];
+		}
+		block[a] = b;
+		sub[a] = std::min(static_cast<int>((f - b) * 8), 7);
+	}
+	return true;
+}
+
+/** \brief Computes cells of a voro++ container with its own search state.
+ *
+ * The container's compute_cell uses search buffers that belong to the container,
+ * so only one cell can be computed at a time. Every thread computing cells
+ * concurrently therefore uses its own instance of this class instead.
+ */
+template<class c_class>
+class CellComputer
+{
+public:
+	CellComputer(c_class& con_)
+		: con(con_), vc(con_, con_.xperiodic ? 2 * con_.nx + 1 : con_.nx, con_.yperiodic ? 2 * con_.ny + 1 : con_.ny, con_.zperiodic ? 2 * con_.nz + 1 : con_.nz) {}
+	
+	// computes the cell of particle q in block ijk
+	template<class v_cell>
+	bool compute_cell(v_cell& c, int ijk, int q)
+	{
+		int k = ijk / con.nxy, ijkt = ijk - con.nxy * k, j = ijkt / con.nx, i = ijkt - j * con.nx;
+		return vc.compute_cell(c, ijk, q, i, j, k);
+	}
+	
+	// returns the id of the particle whose cell contains (x, y, z), like
+	// find_voronoi_cell of the container, or -1 if the position lies outside of
+	// the container or there is no particle
+	int find_cell(double x, double y, double z)
+	{
+		double pos[3] = {x, y, z};
+		int block[3], sub[3];
+		if (!locate_block(con, pos, block, sub))
+			return -1;
+		voro::particle_record w;
+		double mrs;
+		int ijk = block[0] + con.nx * block[1] + con.nxy * block[2];
+		vc.find_voronoi_cell(pos[0], pos[1], pos[2], block[0], block[1], block[2], ijk, w, mrs);
+		return w.ijk == -1 ? -1 : con.id[w.ijk][w.l];
+	}
+
+private:
+	c_class& con;
+	voro::voro_compute<c_class> vc;
+};
+
+
+/** \brief Spreads the lower 21 bits of v such that two zero bits follow each.
+ */
+inline uint64_t spread_bits(uint64_t v)
+{
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+	return v;
+}
+
+// Interleaves the bits of (i,j,k) to their Morton key.
+inline uint64_t morton_key(int i, int j, int k)
+{
+	return spread_bits(i) | spread_bits(j) << 1 | spread_bits(k) << 2;
+}
+
+/** \brief Sorts keys and a permutation along with them by an LSD radix sort,
+ * which only runs passes over the bytes in use.
+ */
+inline void radix_sort(std::vector<uint64_t>& keys, std::vector<int>& order, std::vector<uint64_t>& keys_tmp, std::vector<int>& order_tmp)
+{
+	uint64_t used = 0;
+	for (uint64_t k : keys)
+		used |= k;
+	keys_tmp.resize(keys.size());
+	order_tmp.resize(order.size());
+	for (int shift = 0; shift < 64 && (used >> shift) != 0; shift += 8)
+	{
+		size_t start[257] = {0};
+		for (uint64_t k : keys)
+			++start[((k >> shift) & 255) + 1];
+		for (int d = 0; d < 256; ++d)
+			start[d + 1] += start[d];
+		for (size_t i = 0; i < keys.size(); ++i)
+		{
+			size_t pos = start[(keys[i] >> shift) & 255]++;
+			keys_tmp[pos] = keys[i];
+			order_tmp[pos] = order[i];
+		}
+		keys.swap(keys_tmp);
+		order.swap(order_tmp);
+	}
+}
+
+
+/** \brief Inserts a particle into a container and records its location in vo.
+ *
+ * The radius is only stored by containers for particles with radii.
+ */
+inline void put_particle(voro::container& con, voro::particle_order& vo, int id, double x, double y, double z, double)
+{
+	con.put(vo, id, x, y, z);
+}
+
+inline void put_particle(voro::container_poly& con, voro::particle_order& vo, int id, double x, double y, double z, double r)
+{
+	con.put(vo, id, x, y, z, r);
+}
+
+/** \brief Updates the maximum radius of a container for particles with radii
+ * after a particle was written to its blocks directly, as put does.
+ */
+inline void update_max_radius(voro::container&, double) {}
+
+inline void update_max_radius(voro::container_poly& con, double r)
+{
+	if (r > con.max_radius)
+		con.max_radius = r;
+}
+
+/** \brief Inserts particles into a container in spatially sorted order.
+ *
+ * Keeps its sort buffers between insertions, so that repeated bulk insertions
+ * do not reallocate them.
+ */
+class SortedInserter
+{
+public:
+	// inserts n particles with coordinates (x[i*stride], y[i*stride], z[i*stride])
+	// and radii r[i], if given, ordered by the Morton key of their block followed
+	// by the Morton key of their position on a 8x8x8 grid within the block, such
+	// that nearby particles are stored close to each other; the storage of every
+	// block is grown to its exact new size once, in the same order; particles
+	// outside of the container are skipped and periodic images are moved into it
+	// like by put; the locations of the particles are recorded in index; returns
+	// the number of particles inserted
+	template<class c_class>
+	size_t insert(c_class& c, const int* ids, const double* x, const double* y, const double* z, const double* r, size_t stride, size_t n, std::unordered_map<int, ParticleLocation>& index)
+	{
+		sort_keys.clear();
+		sort_order.clear();
+		sort_blocks.resize(n);
+		sort_xyz.resize(4 * n);
+		block_added.assign(c.nxyz, 0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			double* pos = sort_xyz.data() + 4 * i;
+			pos[0] = x[i * stride];
+			pos[1] = y[i * stride];
+			pos[2] = z[i * stride];
+			pos[3] = r ? r[i] : 0;
+			int block[3], sub[3];
+			if (!locate_block(c, pos, block, sub))
+				continue;
+			int ijk = block[0] + c.nx * block[1] + c.nxy * block[2];
+			sort_keys.push_back(morton_key(block[0], block[1], block[2]) << 9 | morton_key(sub[0], sub[1], sub[2]));
+			sort_order.push_back(static_cast<int>(i));
+			sort_blocks[i] = ijk;
+			++block_added[ijk];
+		}
+		radix_sort(sort_keys, sort_order, sort_keys_tmp, sort_order_tmp);
+		
+		for (int i : sort_order)
+		{
+			int ijk = sort_blocks[i];
+			// grow the block when its first new particle comes up
+			if (block_added[ijk] > 0)
+			{
+				grow_block(c, ijk, c.co[ijk] + block_added[ijk]);
+				block_added[ijk] = 0;
+			}
+			int q = c.co[ijk]++;
+			c.id[ijk][q] = ids[i];
+			// the radius is only copied into containers for particles with radii
+			const double* pos = sort_xyz.data() + 4 * i;
+			std::copy(pos, pos + c.ps, c.p[ijk] + c.ps * q);
+			update_max_radius(c, pos[3]);
+			index[ids[i]] = {ijk, q};
+		}
+		return sort_order.size();
+	}
+	
+	// reallocates the storage of a block for exactly size particles if it is smaller
+	template<class c_class>
+	static void grow_block(c_class& c, int ijk, int size)
+	{
+		if (c.mem[ijk] >= size)
+			return;
+		int* id = new int[size];
+		std::copy(c.id[ijk], c.id[ijk] + c.co[ijk], id);
+		delete[] c.id[ijk];
+		c.id[ijk] = id;
+		double* pp = new double[c.ps * size];
+		std::copy(c.p[ijk], c.p[ijk] + c.ps * c.co[ijk], pp);
+		delete[] c.p[ijk];
+		c.p[ijk] = pp;
+		c.mem[ijk] = size;
+	}
+
+private:
+	std::vector<uint64_t> sort_keys, sort_keys_tmp;
+	std::vector<int> sort_order, sort_order_tmp, sort_blocks, block_added;
+	std::vector<double> sort_xyz;
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * Per-cell numerical kernels of the voro-js wrapper.
+ *
+ * These loops run for every extracted cell. When compiled with -msimd128 they
+ * process two vertices or two triangles at a time in f64x2 lanes, otherwise
+ * the scalar fallback is used. Both paths give the same results up to rounding.
+*/
+
+#ifndef VOROJS_KERNELS_HH
+#define VOROJS_KERNELS_HH
+
+#include <cmath>
+#include <cstddef>
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+
+/** \brief Translates vertices to global coordinates.
+ * \param[in] local the n vertices [x1, y1, z1, ...] relative to the particle.
+ * \param[in] (x,y,z) the position of the particle.
+ * \param[out] out the translated vertices, may be equal to local.
+ */
+inline void translate_vertices(const double* local, size_t n, double x, double y, double z, double* out)
+{
+	size_t i = 0;
+#ifdef __wasm_simd128__
+	// Two vertices fill three lanes pairs as (x, y), (z, x), (y, z).
+	const v128_t xy = wasm_f64x2_make(x, y);
+	const v128_t zx = wasm_f64x2_make(z, x);
+	const v128_t yz = wasm_f64x2_make(y, z);
+	for (; i + 2 <= n; i += 2)
+	{
+		const double* l = local + 3 * i;
+		double* o = out + 3 * i;
+		wasm_v128_store(o, wasm_f64x2_add(wasm_v128_load(l), xy));
+		wasm_v128_store(o + 2, wasm_f64x2_add(wasm_v128_load(l + 2), zx));
+		wasm_v128_store(o + 4, wasm_f64x2_add(wasm_v128_load(l + 4), yz));
+	}
+#endif
+	for (; i < n; ++i)
+	{
+		out[3 * i] = local[3 * i] + x;
+		out[3 * i + 1] = local[3 * i + 1] + y;
+		out[3 * i + 2] = local[3 * i + 2] + z;
+	}
+}
+
+/** \brief Computes the volume and centroid of a cell.
+ * The cell is decomposed into tetrahedra between the local origin and a fan
+ * triangulation of every face, whose signed volumes and centroids are summed.
+ * \param[in] v the vertices [x1, y1, z1, ...] relative to the particle.
+ * \param[in] fv the faces in voro++ format [f1#, f1_v1, f1v2, ... fn#, fn_v1, ...].
+ * \param[out] (cx,cy,cz) the centroid relative to the particle.
+ * \return The volume of the cell.
+ */
+inline double cell_volume_centroid(const double* v, const int* fv, size_t fv_size, double& cx, double& cy, double& cz)
+{
+	// Six times the signed volume and the volume weighted sum of the vertices.
+	double det = 0, sx = 0, sy = 0, sz = 0;
+#ifdef __wasm_simd128__
+	v128_t det2 = wasm_f64x2_splat(0), sx2 = det2, sy2 = det2, sz2 = det2;
+#endif
+	for (size_t i = 0; i < fv_size; i += fv[i] + 1)
+	{
+		const int n = fv[i];
+		const int* face = fv + i + 1;
+		const double* p0 = v + 3 * face[0];
+		int j = 1;
+#ifdef __wasm_simd128__
+		// Triangles (p0, pj, pj+1) and (p0, pj+1, pj+2) side by side in the lanes.
+		const v128_t ox = wasm_f64x2_splat(p0[0]), oy = wasm_f64x2_splat(p0[1]), oz = wasm_f64x2_splat(p0[2]);
+		for (; j + 3 <= n; j += 2)
+		{
+			const double* a0 = v + 3 * face[j];
+			const double* a1 = v + 3 * face[j + 1];
+			const double* a2 = v + 3 * face[j + 2];
+			const v128_t ax = wasm_f64x2_make(a0[0], a1[0]), ay = wasm_f64x2_make(a0[1], a1[1]), az = wasm_f64x2_make(a0[2], a1[2]);
+			const v128_t bx = wasm_f64x2_make(a1[0], a2[0]), by = wasm_f64x2_make(a1[1], a2[1]), bz = wasm_f64x2_make(a1[2], a2[2]);
+			const v128_t crx = wasm_f64x2_sub(wasm_f64x2_mul(ay, bz), wasm_f64x2_mul(az, by));
+			const v128_t cry = wasm_f64x2_sub(wasm_f64x2_mul(az, bx), wasm_f64x2_mul(ax, bz));
+			const v128_t crz = wasm_f64x2_sub(wasm_f64x2_mul(ax, by), wasm_f64x2_mul(ay, bx));
+			const v128_t d = wasm_f64x2_add(wasm_f64x2_add(wasm_f64x2_mul(ox, crx), wasm_f64x2_mul(oy, cry)), wasm_f64x2_mul(oz, crz));
+			det2 = wasm_f64x2_add(det2, d);
+			sx2 = wasm_f64x2_add(sx2, wasm_f64x2_mul(d, wasm_f64x2_add(ox, wasm_f64x2_add(ax, bx))));
+			sy2 = wasm_f64x2_add(sy2, wasm_f64x2_mul(d, wasm_f64x2_add(oy, wasm_f64x2_add(ay, by))));
+			sz2 = wasm_f64x2_add(sz2, wasm_f64x2_mul(d, wasm_f64x2_add(oz, wasm_f64x2_add(az, bz))));
+		}
+#endif
+		for (; j + 2 <= n; ++j)
+		{
+			const double* a = v + 3 * face[j];
+			const double* b = v + 3 * face[j + 1];
+			const double d = p0[0] * (a[1] * b[2] - a[2] * b[1]) + p0[1] * (a[2] * b[0] - a[0] * b[2]) + p0[2] * (a[0] * b[1] - a[1] * b[0]);
+			det += d;
+			sx += d * (p0[0] + a[0] + b[0]);
+			sy += d * (p0[1] + a[1] + b[1]);
+			sz += d * (p0[2] + a[2] + b[2]);
+		}
+	}
+#ifdef __wasm_simd128__
+	det += wasm_f64x2_extract_lane(det2, 0) + wasm_f64x2_extract_lane(det2, 1);
+	sx += wasm_f64x2_extract_lane(sx2, 0) + wasm_f64x2_extract_lane(sx2, 1);
+	sy += wasm_f64x2_extract_lane(sy2, 0) + wasm_f64x2_extract_lane(sy2, 1);
+	sz += wasm_f64x2_extract_lane(sz2, 0) + wasm_f64x2_extract_lane(sz2, 1);
+#endif
+	// The orientation of the faces cancels out in the centroid.
+	if (det == 0)
+	{
+		cx = cy = cz = 0;
+		return 0;
+	}
+	cx = 0.25 * sx / det;
+	cy = 0.25 * sy / det;
+	cz = 0.25 * sz / det;
+	return std::fabs(det) / 6.0;
+}
+
+/** \brief Computes the area and unit normal of a single face.
+ * \param[in] v the vertices [x1, y1, z1, ...] of the cell.
+ * \param[in] face the n vertex numbers of the face.
+ * \param[out] normal the unit normal, oriented along the order of the vertices.
+ * \return The area of the face.
+ */
+inline double face_area_normal(const double* v, const int* face, int n, double normal[3])
+{
+	// Twice the vector area as the sum of fan triangle cross products.
+	double nx = 0, ny = 0, nz = 0;
+	const double* p0 = v + 3 * face[0];
+	int j = 1;
+#ifdef __wasm_simd128__
+	v128_t nx2 = wasm_f64x2_splat(0), ny2 = nx2, nz2 = nx2;
+	const v128_t ox = wasm_f64x2_splat(p0[0]), oy = wasm_f64x2_splat(p0[1]), oz = wasm_f64x2_splat(p0[2]);
+	for (; j + 3 <= n; j += 2)
+	{
+		const double* a0 = v + 3 * face[j];
+		const double* a1 = v + 3 * face[j + 1];
+		const double* a2 = v + 3 * face[j + 2];
+		const v128_t ax = wasm_f64x2_sub(wasm_f64x2_make(a0[0], a1[0]), ox);
+		const v128_t ay = wasm_f64x2_sub(wasm_f64x2_make(a0[1], a1[1]), oy);
+		const v128_t az = wasm_f64x2_sub(wasm_f64x2_make(a0[2], a1[2]), oz);
+		const v128_t bx = wasm_f64x2_sub(wasm_f64x2_make(a1[0], a2[0]), ox);
+		const v128_t by = wasm_f64x2_sub(wasm_f64x2_make(a1[1], a2[1]), oy);
+		const v128_t bz = wasm_f64x2_sub(wasm_f64x2_make(a1[2], a2[2]), oz);
+		nx2 = wasm_f64x2_add(nx2, wasm_f64x2_sub(wasm_f64x2_mul(ay, bz), wasm_f64x2_mul(az, by)));
+		ny2 = wasm_f64x2_add(ny2, wasm_f64x2_sub(wasm_f64x2_mul(az, bx), wasm_f64x2_mul(ax, bz)));
+		nz2 = wasm_f64x2_add(nz2, wasm_f64x2_sub(wasm_f64x2_mul(ax, by), wasm_f64x2_mul(ay, bx)));
+	}
+	nx = wasm_f64x2_extract_lane(nx2, 0) + wasm_f64x2_extract_lane(nx2, 1);
+	ny = wasm_f64x2_extract_lane(ny2, 0) + wasm_f64x2_extract_lane(ny2, 1);
+	nz = wasm_f64x2_extract_lane(nz2, 0) + wasm_f64x2_extract_lane(nz2, 1);
+#endif
+	for (; j + 2 <= n; ++j)
+	{
+		const double* a = v + 3 * face[j];
+		const double* b = v + 3 * face[j + 1];
+		const double ax = a[0] - p0[0], ay = a[1] - p0[1], az = a[2] - p0[2];
+		const double bx = b[0] - p0[0], by = b[1] - p0[1], bz = b[2] - p0[2];
+		nx += ay * bz - az * by;
+		ny += az * bx - ax * bz;
+		nz += ax * by - ay * bx;
+	}
+	const double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+	if (len == 0)
+	{
+		normal[0] = normal[1] = normal[2] = 0;
+		return 0;
+	}
+	normal[0] = nx / len;
+	normal[1] = ny / len;
+	normal[2] = nz / len;
+	return 0.5 * len;
+}
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * Signed distance functions for the native geometry walls of the voro-js wrapper.
+ *
+ * A shape is a tree of unions and intersections over primitives or a sampled
+ * distance grid. The signed distance is negative inside the shape, zero on its
+ * surface and positive outside.
+*/
+
+#ifndef VOROJS_SDF_HH
+#define VOROJS_SDF_HH
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+
+/** \brief A node of a signed distance tree.
+ *
+ * The meaning of the parameters depends on the type of the node:
+ * - SDF_SPHERE: center (p[0..2]) and radius p[3].
+ * - SDF_BOX: minimum (p[0..2]) and maximum (p[3..5]) corner.
+ * - SDF_CAPSULE: segment end points (p[0..2]) and (p[3..5]) and radius p[6].
+ * - SDF_TORUS: center (p[0..2]), major radius p[3] and minor radius p[4], around the z axis.
+ * - SDF_HALFSPACE: normal (p[0..2]) and displacement p[3], inside where n.x <= d.
+ * - SDF_GRID: minimum (p[0..2]) and maximum (p[3..5]) corner of the samples in
+ *   values, which are indexed as i + dims[0] * (j + dims[1] * k).
+ * - SDF_UNION, SDF_INTERSECTION: the children.
+ */
+struct SdfNode
+{
+	enum Type { SDF_SPHERE, SDF_BOX, SDF_CAPSULE, SDF_TORUS, SDF_HALFSPACE, SDF_GRID, SDF_UNION, SDF_INTERSECTION };
+
+	Type type;
+	double p[7] = {0, 0, 0, 0, 0, 0, 0};
+	std::vector<SdfNode> children;
+	int dims[3] = {0, 0, 0};
+	std::vector<double> values;
+
+	/** \brief Evaluates the signed distance at a point.
+	 * \param[in] (x,y,z) the point.
+	 * \return The signed distance of the point to the surface.
+	 */
+	double eval(double x, double y, double z) const
+	{
+		switch (type)
+		{
+			case SDF_SPHERE:
+				return length(x - p[0], y - p[1], z - p[2]) - p[3];
+			case SDF_BOX:
+			{
+				double qx = std::fabs(x - 0.5 * (p[0] + p[3])) - 0.5 * (p[3] - p[0]);
+				double qy = std::fabs(y - 0.5 * (p[1] + p[4])) - 0.5 * (p[4] - p[1]);
+				double qz = std::fabs(z - 0.5 * (p[2] + p[5])) - 0.5 * (p[5] - p[2]);
+				return length(std::max(qx, 0.0), std::max(qy, 0.0), std::max(qz, 0.0)) + std::min(std::max(qx, std::max(qy, qz)), 0.0);
+			}
+			case SDF_CAPSULE:
+			{
+				double ax = x - p[0], ay = y - p[1], az = z - p[2];
+				double bx = p[3] - p[0], by = p[4] - p[1], bz = p[5] - p[2];
+				double bb = bx * bx + by * by + bz * bz;
+				double h = bb > 0 ? std::min(std::max((ax * bx + ay * by + az * bz) / bb, 0.0), 1.0) : 0;
+				return length(ax - h * bx, ay - h * by, az - h * bz) - p[6];
+			}
+			case SDF_TORUS:
+			{
+				double q = std::sqrt((x - p[0]) * (x - p[0]) + (y - p[1]) * (y - p[1])) - p[3];
+				return std::sqrt(q * q + (z - p[2]) * (z - p[2])) - p[4];
+			}
+			case SDF_HALFSPACE:
+				return (p[0] * x + p[1] * y + p[2] * z - p[3]) / length(p[0], p[1], p[2]);
+			case SDF_GRID:
+				return eval_grid(x, y, z);
+			case SDF_UNION:
+			{
+				double d = HUGE_VAL;
+				for (const SdfNode& child : children)
+					d = std::min(d, child.eval(x, y, z));
+				return d;
+			}
+			case SDF_INTERSECTION:
+			{
+				double d = -HUGE_VAL;
+				for (const SdfNode& child : children)
+					d = std::max(d, child.eval(x, y, z));
+				return d;
+			}
+		}
+		return HUGE_VAL;
+	}
+
+	/** \brief Computes the outward unit normal at a point by central differences.
+	 * \param[in] (x,y,z) the point.
+	 * \param[out] (nx,ny,nz) the normalized gradient of the signed distance.
+	 * \return False if the gradient vanishes, true otherwise.
+	 */
+	bool normal(double x, double y, double z, double& nx, double& ny, double& nz) const
+	{
+		const double h = 1e-6 * std::max(1.0, std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z))));
+		nx = eval(x + h, y, z) - eval(x - h, y, z);
+		ny = eval(x, y + h, z) - eval(x, y - h, z);
+		nz = eval(x, y, z + h) - eval(x, y, z - h);
+		// The differences span 2h, so this requires a gradient of at least 1e-6.
+		double len = length(nx, ny, nz);
+		if (len < 2e-6 * h)
+			return false;
+		nx /= len;
+		ny /= len;
+		nz /= len;
+		return true;
+	}
+
+private:
+	static double length(double x, double y, double z)
+	{
+		return std::sqrt(x * x + y * y + z * z);
+	}
+
+	// Trilinear interpolation of the samples, points outside of the grid use the
+	// value at the closest point of the grid plus the distance to it.
+	double eval_grid(double x, double y, double z) const
+	{
+		const double in[3] = {x, y, z};
+		int i0[3];
+		double t[3], outside[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			double c = std::min(std::max(in[a], p[a]), p[a + 3]);
+			outside[a] = in[a] - c;
+			double f = p[a + 3] > p[a] ? (c - p[a]) / (p[a + 3] - p[a]) * (dims[a] - 1) : 0;
+			i0[a] = std::min(static_cast<int>(f), std::max(dims[a] - 2, 0));
+			t[a] = dims[a] > 1 ? f - i0[a] : 0;
+		}
+		const int sx = dims[0] > 1 ? 1 : 0, sy = dims[1] > 1 ? dims[0] : 0, sz = dims[2] > 1 ? dims[0] * dims[1] : 0;
+		const double* v = values.data() + i0[0] + dims[0] * (i0[1] + dims[1] * i0[2]);
+		double c00 = v[0] + t[0] * (v[sx] - v[0]);
+		double c10 = v[sy] + t[0] * (v[sy + sx] - v[sy]);
+		double c01 = v[sz] + t[0] * (v[sz + sx] - v[sz]);
+		double c11 = v[sz + sy] + t[0] * (v[sz + sy + sx] - v[sz + sy]);
+		double c0 = c00 + t[1] * (c10 - c00);
+		double c1 = c01 + t[1] * (c11 - c01);
+		return c0 + t[2] * (c1 - c0) + length(outside[0], outside[1], outside[2]);
+	}
+};
+
+#endif
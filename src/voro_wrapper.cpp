@@ -9,32 +9,26 @@
 
 #include <emscripten/bind.h>
 #include <vector>
-#include <set>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#ifdef VOROJS_THREADS
+#include <thread>
+#endif
 #include "../voro++/src/voro++.hh"
+#include "voro_core.hh"
+#include "voro_sdf.hh"
 
-
-/** \brief Helper structure to represent a 3d point for easy JavaScript interaction.
- */
-struct Point3D
-{
-	double x;
-	double y;
-	double z;
-};
-
-/** \brief Helper structure to represent a Voronoi cell's properties for JavaScript.
- */
-struct VoronoiCell
-{
-	int id;
-	Point3D position;
-	double volume;
-	std::vector<Point3D> vertices;
-	std::vector<std::vector<int>> edges;
-	std::vector<std::vector<int>> faces;
-	std::vector<int> neighbors;
-};
+// Maximum number of threads used for computing cells, the multithreaded builds
+// define VOROJS_THREADS as the size of their pthread pool.
+#ifdef VOROJS_THREADS
+constexpr int max_threads = VOROJS_THREADS;
+#else
+constexpr int max_threads = 1;
+#endif
 
 
 /** \brief Helper functions for JavaScript conversion.
@@ -59,6 +53,12 @@ emscripten::val intsToJSArray(const std::vector<int>& v) {
 	return arr;
 }
 
+emscripten::val doublesToJSArray(const std::vector<double>& v) {
+	emscripten::val arr = emscripten::val::array();
+	for (double d : v) arr.call<void>("push", d);
+	return arr;
+}
+
 emscripten::val facesToJSArray(const std::vector<std::vector<int>>& v) {
 	emscripten::val arr = emscripten::val::array();
 	for (const auto& face : v) arr.call<void>("push", intsToJSArray(face));
@@ -77,6 +77,76 @@ emscripten::val cellToJS(const VoronoiCell& c) {
 	return obj;
 }
 
+// Copies a JS typed array into a (reused) vector with a single memcpy on the heap.
+template<typename T>
+void typedArrayToVector(const emscripten::val& arr, std::vector<T>& out) {
+	out.resize(arr["length"].as<size_t>());
+	emscripten::val view(emscripten::typed_memory_view(out.size(), out.data()));
+	view.call<void>("set", arr);
+}
+
+// Exposes a neighbor graph as typed array views on the WebAssembly heap, with
+// the same lifetime as those of flatToJS; areas are only set if computed.
+emscripten::val graphToJS(const NeighborGraph& g, bool with_areas) {
+	using emscripten::typed_memory_view;
+	emscripten::val obj = emscripten::val::object();
+	obj.set("count", static_cast<int>(g.ids.size()));
+	obj.set("ids", typed_memory_view(g.ids.size(), g.ids.data()));
+	obj.set("offsets", typed_memory_view(g.offsets.size(), g.offsets.data()));
+	obj.set("neighbors", typed_memory_view(g.neighbors.size(), g.neighbors.data()));
+	obj.set("wallOffsets", typed_memory_view(g.wall_offsets.size(), g.wall_offsets.data()));
+	obj.set("walls", typed_memory_view(g.walls.size(), g.walls.data()));
+	if (with_areas) {
+		obj.set("areas", typed_memory_view(g.areas.size(), g.areas.data()));
+		obj.set("wallAreas", typed_memory_view(g.wall_areas.size(), g.wall_areas.data()));
+	}
+	return obj;
+}
+
+// Exposes a render mesh as typed array views on the WebAssembly heap, with the
+// same lifetime as those of flatToJS.
+emscripten::val meshToJS(const RenderMesh& m) {
+	using emscripten::typed_memory_view;
+	emscripten::val obj = emscripten::val::object();
+	obj.set("count", static_cast<int>(m.ids.size()));
+	obj.set("ids", typed_memory_view(m.ids.size(), m.ids.data()));
+	obj.set("positions", typed_memory_view(m.positions.size(), m.positions.data()));
+	obj.set("vertices", typed_memory_view(m.vertices.size(), m.vertices.data()));
+	obj.set("indices", typed_memory_view(m.indices.size(), m.indices.data()));
+	obj.set("vertexOffsets", typed_memory_view(m.vertex_offsets.size(), m.vertex_offsets.data()));
+	obj.set("indexOffsets", typed_memory_view(m.index_offsets.size(), m.index_offsets.data()));
+	return obj;
+}
+
+// Exposes the flat arrays as typed array views on the WebAssembly heap, these
+// are only valid until the next flat computation or a growth of the heap.
+// With single, its Float32Arrays replace the floating point arrays of f.
+emscripten::val flatToJS(const VoronoiCellsFlat& f, const VoronoiCellsFlat32* single = nullptr) {
+	using emscripten::typed_memory_view;
+	emscripten::val obj = emscripten::val::object();
+	obj.set("count", static_cast<int>(f.ids.size()));
+	obj.set("ids", typed_memory_view(f.ids.size(), f.ids.data()));
+	if (single) {
+		obj.set("positions", typed_memory_view(single->positions.size(), single->positions.data()));
+		obj.set("volumes", typed_memory_view(single->volumes.size(), single->volumes.data()));
+		obj.set("centroids", typed_memory_view(single->centroids.size(), single->centroids.data()));
+		obj.set("vertices", typed_memory_view(single->vertices.size(), single->vertices.data()));
+	} else {
+		obj.set("positions", typed_memory_view(f.positions.size(), f.positions.data()));
+		obj.set("volumes", typed_memory_view(f.volumes.size(), f.volumes.data()));
+		obj.set("centroids", typed_memory_view(f.centroids.size(), f.centroids.data()));
+		obj.set("vertices", typed_memory_view(f.vertices.size(), f.vertices.data()));
+	}
+	obj.set("vertexOffsets", typed_memory_view(f.vertex_offsets.size(), f.vertex_offsets.data()));
+	obj.set("faceOffsets", typed_memory_view(f.face_offsets.size(), f.face_offsets.data()));
+	obj.set("neighbors", typed_memory_view(f.neighbors.size(), f.neighbors.data()));
+	obj.set("faceVertices", typed_memory_view(f.face_vertices.size(), f.face_vertices.data()));
+	obj.set("faceVertexOffsets", typed_memory_view(f.face_vertex_offsets.size(), f.face_vertex_offsets.data()));
+	obj.set("edges", typed_memory_view(f.edges.size(), f.edges.data()));
+	obj.set("edgeOffsets", typed_memory_view(f.edge_offsets.size(), f.edge_offsets.data()));
+	return obj;
+}
+
 
 
 /** \brief A C++ proxy class that wraps a JavaScript wall object.
@@ -104,6 +174,9 @@ public:
 		return wall_js_object.call<bool>("point_inside", x, y, z);
 	}
 	
+	// Statistics of the owning context, null while they are disabled.
+	ContextStats* stats = nullptr;
+	
 	/** \brief Cuts a voronoicell by the JavaScript wall. This overrides the
 	 * pure virtual function in the base voro::wall class.
 	 */
@@ -131,7 +204,13 @@ private:
 	bool cut_cell_internal(v_cell &c, double x, double y, double z)
 	{
 		// Forward the call to the 'cut_cell' method on the JS object.
-		emscripten::val plane_params = wall_js_object.call<emscripten::val>("cut_cell", x, y, z);
+		emscripten::val plane_params = emscripten::val::undefined();
+		{
+			PhaseTimer timer(stats ? &stats->js_wall_ms : nullptr);
+			plane_params = wall_js_object.call<emscripten::val>("cut_cell", x, y, z);
+		}
+		if (stats)
+			++stats->js_wall_calls;
 
 		// Check if the JS function returned a valid object indicating a cut.
 		if (!plane_params.isUndefined() && !plane_params.isNull() && plane_params["cut"].as<bool>())
@@ -149,243 +228,1796 @@ private:
 	}
 };
 
+/** \brief A C++ proxy class for a JavaScript wall that cuts many cells per call.
+ *
+ * The JavaScript object implements cut_cells(positions), which takes the
+ * particle positions [x1, y1, z1, ...] as a Float64Array and returns a
+ * Float64Array of one row (cut, nx, ny, nz, d) per particle. Rows with a
+ * non-zero cut cut the cell of that particle by the plane (nx, ny, nz, d) as
+ * returned by cut_cell of a WallJS. The context prepares the rows of all
+ * particles with a single call before computing all cells, other cells are cut
+ * with a call for their particle alone.
+ */
+class WallJSBatched : public voro::wall
+{
+public:
+	WallJSBatched(emscripten::val js_obj, int w_id_ = -99) : wall(), wall_js_object(js_obj), w_id(w_id_) {}
+	
+	/** \brief Tests a point by calling the optional JavaScript implementation,
+	 * points are inside if there is none.
+	 */
+	bool point_inside(double x, double y, double z) override
+	{
+		if (wall_js_object["point_inside"].isUndefined())
+			return true;
+		return wall_js_object.call<bool>("point_inside", x, y, z);
+	}
+	
+	bool cut_cell(voro::voronoicell &c, double x, double y, double z) override
+	{
+		return cut_cell_internal(c, x, y, z);
+	}
+	
+	bool cut_cell(voro::voronoicell_neighbor &c, double x, double y, double z) override
+	{
+		return cut_cell_internal(c, x, y, z);
+	}
+	
+	// calls JavaScript once for the cutting planes of all given particles
+	void prepare(const std::vector<double>& positions, std::vector<double>& rows)
+	{
+		cut_rows(positions, rows);
+	}
+	
+	// cuts a cell by the prepared row of the particle at the given slot
+	template<class v_cell>
+	bool apply(v_cell &c, const std::vector<double>& rows, int slot) const
+	{
+		return apply_row(c, rows.data() + 5 * slot);
+	}
+	
+	// statistics of the owning context, null while they are disabled
+	ContextStats* stats = nullptr;
+
+private:
+	// The JavaScript object that implements the wall logic.
+	emscripten::val wall_js_object;
+	int w_id;
+	// Buffers for the row (cut, nx, ny, nz, d) of a single cell.
+	std::vector<double> single_position;
+	std::vector<double> single_row;
+	
+	void cut_rows(const std::vector<double>& positions, std::vector<double>& out)
+	{
+		PhaseTimer timer(stats ? &stats->js_wall_ms : nullptr);
+		if (stats)
+			++stats->js_wall_calls;
+		emscripten::val view(emscripten::typed_memory_view(positions.size(), positions.data()));
+		typedArrayToVector(wall_js_object.call<emscripten::val>("cut_cells", view), out);
+		if (out.size() != positions.size() / 3 * 5) {
+			throw std::runtime_error(std::string("cut_cells of a batched JS wall must return 5 values per particle"));
+		}
+	}
+	
+	template<class v_cell>
+	bool cut_cell_internal(v_cell &c, double x, double y, double z)
+	{
+		single_position.assign({x, y, z});
+		cut_rows(single_position, single_row);
+		return apply_row(c, single_row.data());
+	}
+	
+	template<class v_cell>
+	bool apply_row(v_cell &c, const double* row) const
+	{
+		if (row[0] == 0)
+			return true;
+		return c.nplane(row[1], row[2], row[3], row[4], w_id);
+	}
+};
+
+// Reads a JS array [x, y, z] into three doubles.
+void vec3FromJS(const emscripten::val& arr, double* out)
+{
+	for (int i = 0; i < 3; ++i)
+		out[i] = arr[i].as<double>();
+}
+
+/** \brief Builds a signed distance tree from its JavaScript description.
+ * \param[in] desc an object { type, ... } with the parameters of the shape, or
+ *                 the children of a union or intersection.
+ * \return The root node of the tree.
+ */
+SdfNode sdfFromJS(const emscripten::val& desc)
+{
+	SdfNode node;
+	std::string type = desc["type"].as<std::string>();
+	if (type == "sphere")
+	{
+		node.type = SdfNode::SDF_SPHERE;
+		vec3FromJS(desc["center"], node.p);
+		node.p[3] = desc["radius"].as<double>();
+	}
+	else if (type == "box")
+	{
+		node.type = SdfNode::SDF_BOX;
+		vec3FromJS(desc["min"], node.p);
+		vec3FromJS(desc["max"], node.p + 3);
+	}
+	else if (type == "capsule")
+	{
+		node.type = SdfNode::SDF_CAPSULE;
+		vec3FromJS(desc["a"], node.p);
+		vec3FromJS(desc["b"], node.p + 3);
+		node.p[6] = desc["radius"].as<double>();
+	}
+	else if (type == "torus")
+	{
+		node.type = SdfNode::SDF_TORUS;
+		vec3FromJS(desc["center"], node.p);
+		node.p[3] = desc["majorRadius"].as<double>();
+		node.p[4] = desc["minorRadius"].as<double>();
+	}
+	else if (type == "halfspace")
+	{
+		node.type = SdfNode::SDF_HALFSPACE;
+		vec3FromJS(desc["normal"], node.p);
+		node.p[3] = desc["d"].as<double>();
+	}
+	else if (type == "grid")
+	{
+		node.type = SdfNode::SDF_GRID;
+		vec3FromJS(desc["min"], node.p);
+		vec3FromJS(desc["max"], node.p + 3);
+		emscripten::val dims = desc["dims"];
+		for (int i = 0; i < 3; ++i)
+			node.dims[i] = dims[i].as<int>();
+		typedArrayToVector(desc["values"], node.values);
+		if (node.dims[0] < 1 || node.dims[1] < 1 || node.dims[2] < 1 || node.values.size() != static_cast<size_t>(node.dims[0]) * node.dims[1] * node.dims[2]) {
+			throw std::runtime_error(std::string("addWallSDF failed because of mismatch in grid dims and values sizes"));
+		}
+	}
+	else if (type == "union" || type == "intersection")
+	{
+		node.type = type == "union" ? SdfNode::SDF_UNION : SdfNode::SDF_INTERSECTION;
+		emscripten::val children = desc["children"];
+		int n = children["length"].as<int>();
+		for (int i = 0; i < n; ++i)
+			node.children.push_back(sdfFromJS(children[i]));
+	}
+	else
+	{
+		throw std::runtime_error(std::string("addWallSDF failed because of unknown shape type ") + type);
+	}
+	return node;
+}
+
+/** \brief A wall given by a signed distance tree, evaluated entirely in C++.
+ *
+ * Intersections cut a cell by each of their children, and boxes by each of
+ * their six faces. Like the curved walls of voro++, other shapes cut a cell by
+ * the tangent plane of the surface point closest to its particle, found from
+ * the distance and the gradient of the signed distance function there.
+ */
+class WallSDF : public voro::wall
+{
+public:
+	WallSDF(SdfNode root_, int w_id_ = -99) : root(std::move(root_)), w_id(w_id_) {}
+	
+	bool point_inside(double x, double y, double z) override
+	{
+		return root.eval(x, y, z) <= 0;
+	}
+	
+	bool cut_cell(voro::voronoicell &c, double x, double y, double z) override
+	{
+		return cut_cell_internal(c, x, y, z);
+	}
+	
+	bool cut_cell(voro::voronoicell_neighbor &c, double x, double y, double z) override
+	{
+		return cut_cell_internal(c, x, y, z);
+	}
+
+private:
+	SdfNode root;
+	int w_id;
+	
+	template<class v_cell>
+	bool cut_cell_internal(v_cell &c, double x, double y, double z)
+	{
+		return cut_node(c, root, x, y, z);
+	}
+	
+	// cuts a cell by a node, returns false if the cell was cut away entirely
+	template<class v_cell>
+	bool cut_node(v_cell &c, const SdfNode& node, double x, double y, double z)
+	{
+		if (node.type == SdfNode::SDF_INTERSECTION)
+		{
+			for (const SdfNode& child : node.children)
+				if (!cut_node(c, child, x, y, z))
+					return false;
+			return true;
+		}
+		// Keep the side of the plane n.r <= s with the outward normal n at
+		// distance s from the particle, positive inside the shape.
+		if (node.type == SdfNode::SDF_BOX)
+		{
+			const double pos[3] = {x, y, z};
+			for (int a = 0; a < 3; ++a)
+			{
+				double n[3] = {0, 0, 0};
+				n[a] = 1;
+				if (!c.nplane(n[0], n[1], n[2], 2 * (node.p[a + 3] - pos[a]), w_id))
+					return false;
+				n[a] = -1;
+				if (!c.nplane(n[0], n[1], n[2], 2 * (pos[a] - node.p[a]), w_id))
+					return false;
+			}
+			return true;
+		}
+		double nx, ny, nz;
+		if (!node.normal(x, y, z, nx, ny, nz))
+			return true;
+		double s = -node.eval(x, y, z);
+		return c.nplane(nx, ny, nz, 2 * s, w_id);
+	}
+};
+
 
-// class for the Voronoi context in which all calculations take place
-class VoronoiContext3D
+// class for the Voronoi context in which all calculations take place, on a
+// voro::container or on a voro::container_poly for particles with radii, whose
+// positions are stored with their radius in the blocks
+template<class c_class>
+class VoronoiContext
 {
 public:
     // Constructor: initializes a 3D Voro++ container
-    // Parameters define the bounding box and periodicity
-    VoronoiContext3D(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int n_x = 8, int n_y = 8, int n_z = 8)
-        // Initialize with a coarse 1x1x1 grid; Voro++ will refine it as needed.
-        : con(x_min, x_max, y_min, y_max, z_min, z_max, n_x, n_y, n_z, false, false, false, 8) {}
+    // Parameters define the bounding box, the number of blocks per axis and
+    // whether the container is periodic along each axis
+    VoronoiContext(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int n_x, int n_y, int n_z, bool x_periodic, bool y_periodic, bool z_periodic)
+        : con(make_container(x_min, x_max, y_min, y_max, z_min, z_max, n_x, n_y, n_z, x_periodic, y_periodic, z_periodic)) {}
+    
+    // Constructor: as above, without periodic axes
+    VoronoiContext(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int n_x, int n_y, int n_z)
+        : VoronoiContext(x_min, x_max, y_min, y_max, z_min, z_max, n_x, n_y, n_z, false, false, false) {}
+    
+    // Constructor: initializes a 3D Voro++ container whose blocks are sized for
+    // the expected number of particles, and re-blocked for the actual particles
+    // whenever their density drifts far from the optimum
+    VoronoiContext(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int expected_particles, bool x_periodic, bool y_periodic, bool z_periodic)
+        : auto_grid(true)
+    {
+        int grid[3];
+        optimal_grid(x_max - x_min, y_max - y_min, z_max - z_min, expected_particles, 1, grid);
+        con = make_container(x_min, x_max, y_min, y_max, z_min, z_max, grid[0], grid[1], grid[2], x_periodic, y_periodic, z_periodic);
+    }
+    
+    // Constructor: as above, without periodic axes
+    VoronoiContext(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int expected_particles)
+        : VoronoiContext(x_min, x_max, y_min, y_max, z_min, z_max, expected_particles, false, false, false) {}
+    
+    // Constructor: as above, with the blocks sized at the first computation
+    VoronoiContext(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max)
+        : VoronoiContext(x_min, x_max, y_min, y_max, z_min, z_max, 0) {}
 
 	// adds a single 3d point to the container
 	void addPoint(int id, double x, double y, double z)
 	{
-		con.put(id, x, y, z);
+		addPoint(id, x, y, z, 0);
+	}
+	
+	// adds a single 3d point with radius r to a container for particles with radii
+	void addPoint(int id, double x, double y, double z, double r)
+	{
+		cancel_chunk();
+		bool caching = !cache.empty();
+		bool inserted;
+		{
+			PhaseTimer timer(stats_enabled ? &stats.insert_ms : nullptr);
+			inserted = put_indexed(id, x, y, z, r);
+		}
+		if (stats_enabled && inserted)
+			++stats.particles_inserted;
+		if (inserted && caching)
+			uncache_inserted(id);
+	}
+
+	// moves the 3d point with the given id in place, keeping its radius, only the
+	// cells around its old and new position are recomputed by the next query;
+	// returns false if the id is unknown or the new position lies outside the
+	// container, in which case the particle stays at its old position
+	bool movePoint(int id, double x, double y, double z)
+	{
+		auto it = index.find(id);
+		if (it == index.end())
+			return false;
+		double r = radius(it->second);
+		const double* pp = con->p[it->second.ijk] + con->ps * it->second.q;
+		const double old[3] = {pp[0], pp[1], pp[2]};
+		cancel_chunk();
+		bool caching = !cache.empty();
+		if (caching)
+			uncache_around(id);
+		remove_indexed(id);
+		bool moved = put_indexed(id, x, y, z, r);
+		// like relax, put a rejected particle back where it was
+		if (!moved)
+			put_indexed(id, old[0], old[1], old[2], r);
+		if (caching)
+			uncache_inserted(id);
+		return moved;
 	}
 
-	// TODO: a method to update a point
+	// removes the 3d point with the given id from the container, only the cells
+	// of its former neighbors are recomputed by the next query
+	bool removePoint(int id)
+	{
+		if (index.find(id) == index.end())
+			return false;
+		cancel_chunk();
+		if (!cache.empty())
+			uncache_around(id);
+		remove_indexed(id);
+		return true;
+	}
 
 	// adds multiple 3d points to the container
 	void addPoints(const std::vector<int>& ids, const std::vector<double>& x_coords, const std::vector<double>& y_coords, const std::vector<double>& z_coords)
 	{
+		// bulk insertions invalidate all cached cells
+		cache.clear();
+		cancel_chunk();
 		if (ids.size() != x_coords.size() || ids.size() != y_coords.size() || ids.size() != z_coords.size()) {
 			throw std::runtime_error(std::string("addPoints failed because of mismatch in ids and xyz_coords sizes"));
 		}
-		for (size_t i = 0; i < ids.size(); ++i)
-			con.put(ids[i], x_coords[i], y_coords[i], z_coords[i]);
+		insert_bulk(ids.data(), x_coords.data(), y_coords.data(), z_coords.data(), nullptr, 1, ids.size());
+	}
+	
+	// adds multiple 3d points from an Int32Array of ids and an interleaved Float64Array [x1, y1, z1, ...]
+	void addPointsFlat(emscripten::val ids, emscripten::val xyz)
+	{
+		addPointsFlat(ids, xyz, emscripten::val::undefined());
+	}
+	
+	// as above, with a Float64Array of radii for a container for particles with radii
+	void addPointsFlat(emscripten::val ids, emscripten::val xyz, emscripten::val radii)
+	{
+		// bulk insertions invalidate all cached cells
+		cache.clear();
+		cancel_chunk();
+		typedArrayToVector(ids, staging_ids);
+		typedArrayToVector(xyz, staging_coords);
+		if (3 * staging_ids.size() != staging_coords.size()) {
+			throw std::runtime_error(std::string("addPointsFlat failed because of mismatch in ids and xyz sizes"));
+		}
+		const double* r = stage_radii(radii, staging_ids.size(), "addPointsFlat");
+		const double* pp = staging_coords.data();
+		insert_bulk(staging_ids.data(), pp, pp + 1, pp + 2, r, 3, staging_ids.size());
+	}
+	
+	// adds multiple 3d points from an Int32Array of ids and one Float64Array per coordinate
+	void addPointsSoA(emscripten::val ids, emscripten::val x_coords, emscripten::val y_coords, emscripten::val z_coords)
+	{
+		addPointsSoA(ids, x_coords, y_coords, z_coords, emscripten::val::undefined());
+	}
+	
+	// as above, with a Float64Array of radii for a container for particles with radii
+	void addPointsSoA(emscripten::val ids, emscripten::val x_coords, emscripten::val y_coords, emscripten::val z_coords, emscripten::val radii)
+	{
+		// bulk insertions invalidate all cached cells
+		cache.clear();
+		cancel_chunk();
+		size_t n = ids["length"].as<size_t>();
+		if (x_coords["length"].as<size_t>() != n || y_coords["length"].as<size_t>() != n || z_coords["length"].as<size_t>() != n) {
+			throw std::runtime_error(std::string("addPointsSoA failed because of mismatch in ids and xyz_coords sizes"));
+		}
+		// Stage the coordinates as one block [x1..xn, y1..yn, z1..zn].
+		typedArrayToVector(ids, staging_ids);
+		staging_coords.resize(3 * n);
+		emscripten::val view(emscripten::typed_memory_view(staging_coords.size(), staging_coords.data()));
+		view.call<void>("set", x_coords, 0);
+		view.call<void>("set", y_coords, n);
+		view.call<void>("set", z_coords, 2 * n);
+		const double* r = stage_radii(radii, n, "addPointsSoA");
+		const double* px = staging_coords.data();
+		insert_bulk(staging_ids.data(), px, px + n, px + 2 * n, r, 1, n);
 	}
 	
-	// adds a single plane wall to the container with normal vector (x, y, z) and displacement d
-	void addWallPlane(double x, double y, double z, double d, int id=-99)
+	// sets whether bulk insertions sort the particles spatially, which is on by
+	// default and only switched off for comparison
+	void setSortedInsert(bool sorted)
 	{
-		voro::wall_plane* plane = new voro::wall_plane(x, y, z, d, id);
-		con.add_wall(*plane);
+		sorted_insert = sorted;
+	}
+	
+	// adds a single plane wall to the container with normal vector (x, y, z) and displacement d,
+	// returns the handle of the wall
+	int addWallPlane(double x, double y, double z, double d, int id=-99)
+	{
+		return add_owned_wall(new voro::wall_plane(x, y, z, d, id));
+	}
+	
+	// adds plane walls from a Float64Array [nx1, ny1, nz1, d1, nx2, ...], returns the
+	// handle of the first wall, the others have consecutive handles
+	int addWallPlanes(emscripten::val planes, int id=-99)
+	{
+		typedArrayToVector(planes, staging_coords);
+		if (staging_coords.size() % 4 != 0) {
+			throw std::runtime_error(std::string("addWallPlanes failed because the planes are not given as groups of 4 values"));
+		}
+		int first = next_wall_handle;
+		const double* pl = staging_coords.data();
+		for (size_t i = 0; i < staging_coords.size(); i += 4)
+			add_owned_wall(new voro::wall_plane(pl[i], pl[i + 1], pl[i + 2], pl[i + 3], id));
+		return first;
 	}
 	
 	// adds a spherical wall to the container with center (x, y, z) and radius r
-	void addWallSphere(double x, double y, double z, double r, int id=-99)
+	int addWallSphere(double x, double y, double z, double r, int id=-99)
 	{
-		voro::wall_sphere* sphere = new voro::wall_sphere(x, y, z, r, id);
-		con.add_wall(*sphere);
+		return add_owned_wall(new voro::wall_sphere(x, y, z, r, id));
 	}
 	
 	// adds an open cylindrical wall to the container with axis point (ax, ay, az) axis vector (vx, vy, vz) and radius r
-	void addWallCylinder(double ax, double ay, double az, double vx, double vy, double vz, double r, int id=-99)
+	int addWallCylinder(double ax, double ay, double az, double vx, double vy, double vz, double r, int id=-99)
 	{
-		voro::wall_cylinder* cylinder = new voro::wall_cylinder(ax, ay, az, vx, vy, vz, r, id);
-		con.add_wall(*cylinder);
+		return add_owned_wall(new voro::wall_cylinder(ax, ay, az, vx, vy, vz, r, id));
 	}
 	
 	// adds a conal wall to the container with apex point (ax, ay, az) axis vector (vx, vy, vz) and angle a (in radians)
-	void addWallCone(double ax, double ay, double az, double vx, double vy, double vz, double a, int id=-99)
+	int addWallCone(double ax, double ay, double az, double vx, double vy, double vz, double a, int id=-99)
 	{
-		voro::wall_cone* cone = new voro::wall_cone(ax, ay, az, vx, vy, vz, a, id);
-		con.add_wall(*cone);
+		return add_owned_wall(new voro::wall_cone(ax, ay, az, vx, vy, vz, a, id));
 	}
 	
-	void addWallJS(emscripten::val js_wall)
+	int addWallJS(emscripten::val js_wall)
 	{
-		// Create the cpp proxy wall from the given JS implementation. Create an
-		// instance on the heap to control its lifetime and avoid null pointer exceptions.
-		WallJS* cpp_wall_proxy = new WallJS(js_wall);
-		// Add the proxy wall to the container. The voro++ container now owns this pointer and
-        // is responsible for deleting it upon calling clear() or its own destructor.
-		con.add_wall(*cpp_wall_proxy);
+		// Create the cpp proxy wall from the given JS implementation, which is
+		// owned by the wall registry of this context.
+		WallJS* w = new WallJS(js_wall);
+		w->stats = stats_enabled ? &stats : nullptr;
+		return add_owned_wall(w, true);
 	}
 	
-	// computes and returns all Voronoi cells in the container
-	std::vector<VoronoiCell> getCellsRaw()
+	// adds a JavaScript wall which cuts the cells of many particles per call, see
+	// WallJSBatched; unlike addWallJS it does not prevent multithreading
+	int addWallJSBatched(emscripten::val js_wall, int id=-99)
 	{
-		// init js cells, loop over all cells using the voro++ iterator
-		std::vector<VoronoiCell> cells;
-		voro::c_loop_all cla(con);
-		voro::voronoicell_neighbor c;
-		
-		// check if there are any cells to loop over
-		if (cla.start())
+		WallJSBatched* w = new WallJSBatched(js_wall, id);
+		w->stats = stats_enabled ? &stats : nullptr;
+		owned_walls.push_back({next_wall_handle, std::unique_ptr<voro::wall>(w), false, true});
+		batched_walls.push_back(w);
+		cache.clear();
+		cancel_chunk();
+		return next_wall_handle++;
+	}
+	
+	// adds a wall from a declarative description of its shape, see sdfFromJS,
+	// which is evaluated without calling into JavaScript
+	int addWallSDF(emscripten::val shape, int id=-99)
+	{
+		return add_owned_wall(new WallSDF(sdfFromJS(shape), id));
+	}
+	
+	// removes the wall with the given handle from the container, returns false
+	// if there is no such wall
+	bool removeWall(int handle)
+	{
+		auto it = std::find_if(owned_walls.begin(), owned_walls.end(), [handle](const OwnedWall& w) { return w.handle == handle; });
+		if (it == owned_walls.end())
+			return false;
+		// close the gap in the wall list of the container
+		if (it->batched)
+			batched_walls.erase(std::find(batched_walls.begin(), batched_walls.end(), it->wall.get()));
+		else
 		{
-			do {
-				// compute the cell for the current particle
-				if (con.compute_cell(c, cla))
-				{
-					// create the cell in js and extract all properties from voro++
-					VoronoiCell cell;
-					extract_cell(c, cla, cell);
-					
-					// add this cell to the vector of cells
-					cells.push_back(cell);
-				}
-			}
-			while (cla.inc());
+			voro::wall** wp = std::find(con->walls, con->wep, it->wall.get());
+			std::copy(wp + 1, con->wep, wp);
+			--con->wep;
 		}
-		return cells;
+		if (it->js)
+			--js_walls;
+		owned_walls.erase(it);
+		cache.clear();
+		cancel_chunk();
+		return true;
+	}
+	
+	// removes all walls from the container
+	void clearWalls()
+	{
+		con->wep = con->walls;
+		batched_walls.clear();
+		owned_walls.clear();
+		js_walls = 0;
+		cache.clear();
+		cancel_chunk();
+	}
+	
+	// computes and returns all Voronoi cells in the container
+	std::vector<VoronoiCell> getCellsRaw()
+	{
+		return getCellsRaw(CELL_ALL);
+	}
+	
+	// computes and returns all Voronoi cells with only the given CellField flags
+	std::vector<VoronoiCell> getCellsRaw(int fields)
+	{
+		// cells without neighbor information are cheaper to compute
+		if (fields & CELL_NEIGHBORS)
+			return compute_cells<voro::voronoicell_neighbor>(fields);
+		return compute_cells<voro::voronoicell>(fields);
 	}
 	
 	// computes and returns all Voronoi cells as JS objects
 	emscripten::val getCells()
 	{
-		std::vector<VoronoiCell> cells = getCellsRaw();
+		return getCells(CELL_ALL);
+	}
+	
+	// computes and returns all Voronoi cells as JS objects with only the given fields
+	emscripten::val getCells(int fields)
+	{
+		std::vector<VoronoiCell> cells = getCellsRaw(fields);
 		emscripten::val js_cells = emscripten::val::array();
 		for (const auto& c : cells) {
-			js_cells.call<void>("push", cellToJS(c));
+			js_cells.call<void>("push", cell_to_js(c));
 		}
 		return js_cells;
 	}
 
+	// computes all Voronoi cells into the flat buffers of this context
+	const VoronoiCellsFlat& getCellsFlatRaw(int fields = CELL_ALL)
+	{
+		if (fields & CELL_NEIGHBORS)
+			compute_flat<voro::voronoicell_neighbor>(fields, flat);
+		else
+			compute_flat<voro::voronoicell>(fields, flat);
+		return flat;
+	}
+
+	// computes all Voronoi cells and returns them as typed array views, without
+	// creating a JS object per cell; the views are reused by the next call
+	emscripten::val getCellsFlat()
+	{
+		return flat_to_js(getCellsFlatRaw(), flat32);
+	}
+	
+	emscripten::val getCellsFlat(int fields)
+	{
+		return flat_to_js(getCellsFlatRaw(fields), flat32);
+	}
+
 	// computes and returns a specific Voronoi cell by its ID
 	VoronoiCell getCellRawById(int id)
 	{
 		VoronoiCell cell;
-		voro::c_loop_all cla(con);
-		voro::voronoicell_neighbor c;
-		
-		// check if there are any cells to loop over
-		if (cla.start())
-		{
-			do {
-				// only do something if id matches
-				if (cla.pid() == id)
-				{
-					// compute the cell for the current particle
-					if (con.compute_cell(c, cla))
-					{
-						extract_cell(c, cla, cell);
-						return cell;
-					}
-				}
-			}
-			while (cla.inc());
-		}
+		auto cached = cache.find(id);
+		if (cached != cache.end())
+			return cached->second;
+		// look up the particle in the index and only compute its own cell
+		if (compute_indexed(id, cell))
+			cache.emplace(id, cell);
 		// handle case where cell ID is not found by just returning empty cell
 		return cell;
 	}
 	
+	// computes and returns a specific Voronoi cell by its ID with only the given
+	// fields, such cells bypass the cache of complete cells
+	VoronoiCell getCellRawById(int id, int fields)
+	{
+		if (fields == CELL_ALL)
+			return getCellRawById(id);
+		VoronoiCell cell;
+		if (fields & CELL_NEIGHBORS)
+			compute_indexed<voro::voronoicell_neighbor>(id, fields, cell);
+		else
+			compute_indexed<voro::voronoicell>(id, fields, cell);
+		return cell;
+	}
+	
 	// computes and returns a specific Voronoi cell by its ID as a JS object
 	emscripten::val getCellById(int id)
 	{
-		return cellToJS(getCellRawById(id));
+		return cell_to_js(getCellRawById(id));
 	}
 	
-	// returns a set of points that correspond to a single step in Voronoi relaxation
-	// these are the centroids of the current cells and can serve as input for the algorithm
-	std::vector<Point3D> relaxVoronoi()
+	emscripten::val getCellById(int id, int fields)
 	{
-		std::vector<Point3D> relaxed_points(con.total_particles());
-		
-		// loop over all cells
-		voro::c_loop_all cla(con);
-		voro::voronoicell cell;
-		if (cla.start())
-		{
-			do
-			{
-				if (con.compute_cell(cell, cla))
-				{
-					// Get id and centroid of the cell.
-					int id = cla.pid();
-					double cx, cy, cz;
-					cell.centroid(cx, cy, cz);
-					// Add new relaxed point.
-					Point3D point = {cx, cy, cz};
-					relaxed_points[id] = point;
-					// TODO: fix this potential out of bounds: devise a strategy that passes the ID as well.
-				}
-			}
-			while (cla.inc());
-		}
-		return relaxed_points;
+		return cell_to_js(getCellRawById(id, fields));
 	}
-
-    // Clears all particles from the container
-	void clear()
+	
+	// computes the Voronoi cells for the given Int32Array of IDs into the flat
+	// buffers of this context, IDs which are not in the container are skipped
+	emscripten::val getCellsByIds(emscripten::val ids)
 	{
-		con.clear();
+		return getCellsByIds(ids, CELL_ALL);
 	}
-
-private:
-	// container of voro++ library
-	voro::container con;
 	
-	// extracts all cell details into a VoronoiCell struct instance
-	void extract_cell(voro::voronoicell_neighbor& c, voro::c_loop_all& cla, VoronoiCell& cell)
+	emscripten::val getCellsByIds(emscripten::val ids, int fields)
 	{
-		// Get cell position by call by reference.
-		cla.pos(cell.position.x, cell.position.y, cell.position.z);
-		
-		// Get id and volume.
-		cell.id = cla.pid();
-		cell.volume = c.volume();
-		
-		// Get cell vertices, these are updated by call by reference.
-		std::vector<double> v;
-		c.vertices(cell.position.x, cell.position.y, cell.position.z, v);
-		// Then convert the vertices from [x1, y1, z1, ...] to vector<Point3D>.
-		for (size_t i = 0; i < v.size(); i += 3)
-			cell.vertices.push_back({v[i], v[i+1], v[i+2]});
-		
-		// Get cell faces and orders, these are updated by call by reference.
-		std::vector<int> face_vertices, face_orders;
-		c.face_vertices(face_vertices);
-		c.face_orders(face_orders);
-		
-		// Then convert these two vectors to a vector of vector of ints where
-		// each vector contains the vertex numbers corresponding to a face.
-		// The order contains the number of vertices for the indexed face.
-		int fv_offset = 0;
-		for (int fv_cnt : face_orders)
-		{
-			std::vector<int> current_face;
-			current_face.reserve(fv_cnt);
-			// The structure of cell.face_vertices is [f1#, f1_v1, f1v2, ... fn#, fn_v1, ...]
-			for (int j = 1; j <= fv_cnt; ++j)
-				current_face.push_back(face_vertices[fv_offset + j]);
-			cell.faces.push_back(current_face);
-			fv_offset += (fv_cnt + 1);
-		}
-		
-		// Extract unique edges from the face data.
-		std::set<std::vector<int>> unique_edges;
-		for (const auto& face : cell.faces)
+		typedArrayToVector(ids, staging_ids);
+		flat.clear();
+		if (fields & CELL_NEIGHBORS)
+			compute_ids_flat<voro::voronoicell_neighbor>(fields);
+		else
+			compute_ids_flat<voro::voronoicell>(fields);
+		return flat_to_js(flat, flat32);
+	}
+	
+	// computes the neighbor graph of all cells in compressed sparse row form, in
+	// the order of getCellsFlat, optionally with the areas of the shared faces;
+	// only the neighbors of the cells are extracted
+	emscripten::val getNeighborGraph()
+	{
+		return getNeighborGraph(false);
+	}
+	
+	emscripten::val getNeighborGraph(bool with_areas)
+	{
+		compute_graph(with_areas);
+		PhaseTimer timer(stats_enabled ? &stats.convert_ms : nullptr);
+		if (stats_enabled)
+			stats.bytes_emitted += graph.bytes();
+		return graphToJS(graph, with_areas);
+	}
+	
+	// computes the triangulated surfaces of all cells as interleaved vertices
+	// [px, py, pz, nx, ny, nz] and an index buffer with one draw range per cell,
+	// in the order of getCellsFlat; options { flatNormals, shrink } select
+	// between per face and shared vertices (flat by default) and scale the
+	// cells around their centroids (1 by default)
+	emscripten::val getRenderMesh()
+	{
+		return getRenderMesh(emscripten::val::object());
+	}
+	
+	emscripten::val getRenderMesh(emscripten::val options)
+	{
+		bool flat_normals = options["flatNormals"].isUndefined() || options["flatNormals"].as<bool>();
+		double shrink = options["shrink"].isUndefined() ? 1 : options["shrink"].as<double>();
+		compute_mesh(flat_normals, shrink);
+		PhaseTimer timer(stats_enabled ? &stats.convert_ms : nullptr);
+		if (stats_enabled)
+			stats.bytes_emitted += mesh.bytes();
+		return meshToJS(mesh);
+	}
+	
+	// computes the edges of all cells and returns each geometric edge once, as a
+	// Float32Array view of segment end points [x1, y1, z1, x2, y2, z2, ...]
+	emscripten::val getWireframe()
+	{
+		compute_flat<voro::voronoicell>(CELL_VERTICES | CELL_EDGES, wire_flat);
+		// vertices closer than a ten-millionth of the container size are merged
+		double extent = std::max({con->bx - con->ax, con->by - con->ay, con->bz - con->az});
+		PhaseTimer timer(stats_enabled ? &stats.convert_ms : nullptr);
+		wireframe.build(wire_flat, 1e-7 * extent);
+		if (stats_enabled)
+			stats.bytes_emitted += sizeof(float) * wireframe.segments.size();
+		emscripten::val obj = emscripten::val::object();
+		obj.set("count", static_cast<int>(wireframe.segments.size() / 6));
+		obj.set("segments", emscripten::typed_memory_view(wireframe.segments.size(), wireframe.segments.data()));
+		return obj;
+	}
+	
+	// finds the particles whose cells contain the positions of a Float64Array
+	// [x1, y1, z1, ...] by the block grid, without computing any cell; returns an
+	// Int32Array view of their ids, -1 for positions outside of the container,
+	// which is reused by the next call
+	emscripten::val locatePoints(emscripten::val xyz)
+	{
+		typedArrayToVector(xyz, staging_coords);
+		if (staging_coords.size() % 3 != 0) {
+			throw std::runtime_error(std::string("locatePoints failed because the positions are not given as groups of 3 values"));
+		}
+		update_grid();
+		int n = static_cast<int>(staging_coords.size() / 3);
+		located.resize(n);
+		// every thread searches with its own state for an equal share of the positions
+		auto locate = [this](int begin, int end) {
+			CellComputer<c_class> computer(*con);
+			for (int i = begin; i < end; ++i)
+			{
+				const double* p = staging_coords.data() + 3 * i;
+				located[i] = computer.find_cell(p[0], p[1], p[2]);
+			}
+		};
+#ifdef VOROJS_THREADS
+		int n_threads = concurrent && n >= 1024 ? threads : 1;
+		std::vector<std::thread> pool;
+		for (int t = 1; t < n_threads; ++t)
+			pool.emplace_back(locate, static_cast<int>(static_cast<long long>(n) * t / n_threads), static_cast<int>(static_cast<long long>(n) * (t + 1) / n_threads));
+		locate(0, n / n_threads);
+		for (std::thread& thread : pool)
+			thread.join();
+#else
+		locate(0, n);
+#endif
+		return emscripten::val(emscripten::typed_memory_view(located.size(), located.data()));
+	}
+	
+	// starts computing all cells in chunks, such that a large tessellation can
+	// be spread over several frames; changing the particles or walls cancels
+	// the computation, while other queries may run between the chunks
+	void beginCompute()
+	{
+		beginCompute(CELL_ALL);
+	}
+	
+	void beginCompute(int fields)
+	{
+		// a running computation is restarted, possibly on new blocks
+		cancel_chunk();
+		update_grid();
+		chunk_fields = fields;
+		chunk_ijk = 0;
+		chunk_q = 0;
+		chunk_active = true;
+		prepare_batched_walls(chunk_rows);
+	}
+	
+	// computes the next cells of a chunked computation on the calling thread, at
+	// most max_cells of them and for at most max_millis milliseconds, where limits
+	// of 0 are ignored; at least one cell is computed per call; returns the flat
+	// views of all cells computed since beginCompute, in the order of getCellsFlat
+	emscripten::val computeChunk(int max_cells)
+	{
+		return computeChunk(max_cells, 0);
+	}
+	
+	emscripten::val computeChunk(int max_cells, double max_millis)
+	{
+		if (chunk_active)
+		{
+			if (chunk_fields & CELL_NEIGHBORS)
+				compute_chunk<voro::voronoicell_neighbor>(max_cells, max_millis);
+			else
+				compute_chunk<voro::voronoicell>(max_cells, max_millis);
+		}
+		// the cells of earlier chunks are already converted
+		return flat_to_js(chunk_flat, chunk_flat32, true);
+	}
+	
+	// whether the chunked computation computed all cells, also true before it
+	// was started
+	bool isDone() const
+	{
+		return !chunk_active;
+	}
+	
+	// stops the chunked computation and drops the cells computed so far
+	void cancelCompute()
+	{
+		cancel_chunk();
+	}
+	
+	// returns a set of points that correspond to a single step in Voronoi relaxation
+	// these are the centroids of the current cells in ascending order of their ids
+	// and can serve as input for the algorithm; cells cut away entirely are skipped
+	std::vector<Point3D> relaxVoronoi()
+	{
+		compute_flat<voro::voronoicell>(CELL_VOLUME, relax_flat);
+		std::vector<int> order(relax_flat.ids.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = static_cast<int>(i);
+		std::sort(order.begin(), order.end(), [this](int a, int b) { return relax_flat.ids[a] < relax_flat.ids[b]; });
+		std::vector<Point3D> relaxed_points;
+		relaxed_points.reserve(order.size());
+		for (int i : order)
+		{
+			const double* c = relax_flat.centroids.data() + 3 * i;
+			relaxed_points.push_back({c[0], c[1], c[2]});
+		}
+		return relaxed_points;
+	}
+	
+	// performs up to the given number of Lloyd relaxation steps in place, each
+	// moving every particle to the centroid of its cell, and stops early once no
+	// particle moves further than tolerance; returns the number of iterations,
+	// whether it converged and the maximum and mean displacement per iteration
+	emscripten::val relax(int iterations, double tolerance)
+	{
+		// every particle moves, so all cached cells are outdated
+		cache.clear();
+		cancel_chunk();
+		std::vector<double> max_displacement, mean_displacement;
+		bool converged = false;
+		for (int it = 0; it < iterations && !converged; ++it)
+		{
+			compute_flat<voro::voronoicell>(CELL_VOLUME, relax_flat);
+			double max_d = 0, sum_d = 0;
+			size_t n = relax_flat.ids.size();
+			for (size_t i = 0; i < n; ++i)
+			{
+				int id = relax_flat.ids[i];
+				const double* p = relax_flat.positions.data() + 3 * i;
+				const double* c = relax_flat.centroids.data() + 3 * i;
+				double dx = c[0] - p[0], dy = c[1] - p[1], dz = c[2] - p[2];
+				double d = std::sqrt(dx * dx + dy * dy + dz * dz);
+				max_d = std::max(max_d, d);
+				sum_d += d;
+				// re-insert the particle with its id and radius, it stays in place
+				// if the centroid is rounded to just outside the container
+				double r = radius(index[id]);
+				remove_indexed(id);
+				if (!put_indexed(id, c[0], c[1], c[2], r))
+					put_indexed(id, p[0], p[1], p[2], r);
+			}
+			max_displacement.push_back(max_d);
+			mean_displacement.push_back(n > 0 ? sum_d / n : 0);
+			converged = max_d <= tolerance;
+		}
+		emscripten::val result = emscripten::val::object();
+		result.set("iterations", static_cast<int>(max_displacement.size()));
+		result.set("converged", converged);
+		result.set("maxDisplacement", doublesToJSArray(max_displacement));
+		result.set("meanDisplacement", doublesToJSArray(mean_displacement));
+		return result;
+	}
+	
+	emscripten::val relax(int iterations)
+	{
+		return relax(iterations, 0);
+	}
+	
+	// sets the number of threads used for computing cells, which is limited to
+	// the thread pool of the multithreaded builds and 1 otherwise
+	void setThreads(int n)
+	{
+		threads = std::max(1, std::min(n, max_threads));
+	}
+	
+	int getThreads() const
+	{
+		return threads;
+	}
+	
+	// returns the current number of blocks per axis [nx, ny, nz]
+	emscripten::val getGrid() const
+	{
+		return intsToJSArray({con->nx, con->ny, con->nz});
+	}
+
+    // Clears all particles from the container
+	void clear()
+	{
+		con->clear();
+		index.clear();
+		cache.clear();
+		cancel_chunk();
+	}
+	
+	// sets the precision of the positions, volumes, centroids and vertices of
+	// the flat outputs (getCellsFlat, getCellsByIds, computeChunk) to 32 bits
+	// (Float32Array) or 64 bits (Float64Array, the default), optionally with the
+	// vertices relative to the position of their cell's particle
+	void setPrecision(int bits)
+	{
+		setPrecision(bits, false);
+	}
+	
+	void setPrecision(int bits, bool relative)
+	{
+		if (bits != 32 && bits != 64) {
+			throw std::runtime_error(std::string("setPrecision failed because the precision must be 32 or 64 bits"));
+		}
+		single_precision = bits == 32;
+		relative_vertices = single_precision && relative;
+		// the cells converted so far are in the old format
+		flat32 = chunk_flat32 = VoronoiCellsFlat32();
+	}
+	
+	// enables or disables collecting statistics, which is off by default; the
+	// statistics collected so far are kept
+	void setStatsEnabled(bool enabled)
+	{
+		stats_enabled = enabled;
+		for (OwnedWall& w : owned_walls)
+		{
+			ContextStats* st = enabled ? &stats : nullptr;
+			if (w.batched)
+				static_cast<WallJSBatched*>(w.wall.get())->stats = st;
+			else if (w.js)
+				static_cast<WallJS*>(w.wall.get())->stats = st;
+		}
+	}
+	
+	// returns the statistics collected since the last reset as a JS object
+	emscripten::val getStats()
+	{
+		collect_stats();
+		emscripten::val obj = emscripten::val::object();
+		obj.set("enabled", stats_enabled);
+		obj.set("particlesInserted", static_cast<double>(stats.particles_inserted));
+		obj.set("cellsComputed", static_cast<double>(stats.cells_computed));
+		obj.set("cellsFailed", static_cast<double>(stats.cells_failed));
+		obj.set("jsWallCalls", static_cast<double>(stats.js_wall_calls));
+		obj.set("bytesEmitted", static_cast<double>(stats.bytes_emitted));
+		obj.set("insertMs", stats.insert_ms);
+		obj.set("computeMs", stats.compute_ms);
+		obj.set("jsWallMs", stats.js_wall_ms);
+		obj.set("extractMs", stats.extract_ms);
+		obj.set("packMs", stats.pack_ms);
+		obj.set("convertMs", stats.convert_ms);
+		return obj;
+	}
+	
+	// sets all statistics to zero
+	void resetStats()
+	{
+		collect_stats();
+		stats = ContextStats();
+	}
+
+private:
+	// container of voro++ library, which is replaced when re-blocking
+	std::unique_ptr<c_class> con;
+	
+	static std::unique_ptr<c_class> make_container(double x_min, double x_max, double y_min, double y_max, double z_min, double z_max, int n_x, int n_y, int n_z, bool x_periodic, bool y_periodic, bool z_periodic)
+	{
+		return std::unique_ptr<c_class>(new c_class(x_min, x_max, y_min, y_max, z_min, z_max, n_x, n_y, n_z, x_periodic, y_periodic, z_periodic, 8));
+	}
+	
+	// whether the blocks are sized automatically
+	bool auto_grid = false;
+	// factor by which the particles per occupied block may deviate from the
+	// optimum before the container is re-blocked
+	static constexpr double grid_tolerance = 4;
+	
+	// block counts for n particles like voro++'s pre_container::guess_optimal,
+	// aiming at optimal_particles (5.6) per block in the occupied fraction of
+	// the volume
+	static void optimal_grid(double dx, double dy, double dz, double n, double occupancy, int grid[3])
+	{
+		double ilscale = std::cbrt(n / (voro::optimal_particles * dx * dy * dz * occupancy));
+		grid[0] = std::max(1, static_cast<int>(dx * ilscale + 1));
+		grid[1] = std::max(1, static_cast<int>(dy * ilscale + 1));
+		grid[2] = std::max(1, static_cast<int>(dz * ilscale + 1));
+	}
+	
+	// re-blocks an automatically sized container if the particles per occupied
+	// block drifted too far from the optimum; the blocks are kept during a
+	// chunked computation, whose position refers to them
+	void update_grid()
+	{
+		if (!auto_grid || chunk_active)
+			return;
+		int total = con->total_particles();
+		int occupied = 0;
+		for (int ijk = 0; ijk < con->nxyz; ++ijk)
+			if (con->co[ijk] > 0)
+				++occupied;
+		if (occupied == 0)
+			return;
+		double density = static_cast<double>(total) / occupied;
+		if (density < voro::optimal_particles * grid_tolerance && density > voro::optimal_particles / grid_tolerance)
+			return;
+		// clustered particles occupy only part of the blocks, which is limited
+		// since a coarse grid gives just a rough estimate of it
+		double occupancy = std::max(static_cast<double>(occupied) / con->nxyz, 1.0 / 64);
+		int grid[3];
+		optimal_grid(con->bx - con->ax, con->by - con->ay, con->bz - con->az, total, occupancy, grid);
+		if (grid[0] != con->nx || grid[1] != con->ny || grid[2] != con->nz)
+			rebuild(grid[0], grid[1], grid[2]);
+	}
+	
+	// moves all particles and walls into a new container with the given blocks,
+	// cached cells stay valid as the tessellation does not change; the particles
+	// are not counted as inserted
+	void rebuild(int n_x, int n_y, int n_z)
+	{
+		std::unique_ptr<c_class> old = std::move(con);
+		con = make_container(old->ax, old->bx, old->ay, old->by, old->az, old->bz, n_x, n_y, n_z, old->xperiodic, old->yperiodic, old->zperiodic);
+		for (const OwnedWall& w : owned_walls)
+			if (!w.batched)
+				con->add_wall(*w.wall);
+		std::vector<int> ids;
+		std::vector<double> xyz, radii;
+		for (int ijk = 0; ijk < old->nxyz; ++ijk)
+		{
+			ids.insert(ids.end(), old->id[ijk], old->id[ijk] + old->co[ijk]);
+			for (int q = 0; q < old->co[ijk]; ++q)
+			{
+				const double* pp = old->p[ijk] + old->ps * q;
+				xyz.insert(xyz.end(), pp, pp + 3);
+				if (old->ps == 4)
+					radii.push_back(pp[3]);
+			}
+		}
+		put_bulk(ids.data(), xyz.data(), xyz.data() + 1, xyz.data() + 2, radii.empty() ? nullptr : radii.data(), 3, ids.size());
+	}
+	
+	// index from particle id to its location in the container, which is kept
+	// up to date by all insertions so that single cells are found in O(1)
+	std::unordered_map<int, ParticleLocation> index;
+	voro::particle_order order;
+	
+	// inserts a particle and records where the container stored it, returns
+	// false if the particle lies outside the container
+	bool put_indexed(int id, double x, double y, double z, double r)
+	{
+		// the particle order is only used to report the location of this insertion
+		order.op = order.o;
+		put_particle(*con, order, id, x, y, z, r);
+		if (order.op == order.o)
+			return false;
+		index[id] = {order.o[0], order.o[1]};
+		return true;
+	}
+	
+	// removes an indexed particle from its block by moving the last particle of
+	// the block into its slot
+	void remove_indexed(int id)
+	{
+		auto it = index.find(id);
+		ParticleLocation loc = it->second;
+		index.erase(it);
+		int last = --con->co[loc.ijk];
+		if (loc.q != last)
+		{
+			int moved_id = con->id[loc.ijk][last];
+			con->id[loc.ijk][loc.q] = moved_id;
+			double* pp = con->p[loc.ijk];
+			std::copy(pp + con->ps * last, pp + con->ps * (last + 1), pp + con->ps * loc.q);
+			index[moved_id].q = loc.q;
+		}
+	}
+	
+	// spatially sorted bulk insertion and its buffers
+	bool sorted_insert = true;
+	SortedInserter inserter;
+	std::vector<double> staging_radii;
+	
+	// copies the Float64Array of radii of a bulk insertion of n particles, if
+	// given, and returns them
+	const double* stage_radii(const emscripten::val& radii, size_t n, const char* method)
+	{
+		if (radii.isUndefined())
+			return nullptr;
+		typedArrayToVector(radii, staging_radii);
+		if (staging_radii.size() != n) {
+			throw std::runtime_error(std::string(method) + " failed because of mismatch in ids and radii sizes");
+		}
+		return staging_radii.data();
+	}
+	
+	// radius of an indexed particle, which is 0 in containers without radii
+	double radius(const ParticleLocation& loc) const
+	{
+		return con->ps == 4 ? con->p[loc.ijk][4 * loc.q + 3] : 0;
+	}
+	
+	// inserts n particles with coordinates (x[i*stride], y[i*stride], z[i*stride])
+	// and radii r[i], if given, spatially sorted unless switched off; returns the
+	// number of particles inside the container, which were inserted
+	size_t put_bulk(const int* ids, const double* x, const double* y, const double* z, const double* r, size_t stride, size_t n)
+	{
+		if (sorted_insert)
+			return inserter.insert(*con, ids, x, y, z, r, stride, n, index);
+		size_t inserted = 0;
+		for (size_t i = 0; i < n; ++i)
+			if (put_indexed(ids[i], x[i * stride], y[i * stride], z[i * stride], r ? r[i] : 0))
+				++inserted;
+		return inserted;
+	}
+	
+	// as put_bulk, for insertions by the user which are counted in the statistics
+	void insert_bulk(const int* ids, const double* x, const double* y, const double* z, const double* r, size_t stride, size_t n)
+	{
+		PhaseTimer timer(stats_enabled ? &stats.insert_ms : nullptr);
+		size_t inserted = put_bulk(ids, x, y, z, r, stride, n);
+		if (stats_enabled)
+			stats.particles_inserted += inserted;
+	}
+	
+	// computes the cell of an indexed particle, returns false if the id is
+	// unknown or the cell was cut away entirely
+	bool compute_indexed(int id, VoronoiCell& cell)
+	{
+		return compute_indexed<voro::voronoicell_neighbor>(id, CELL_ALL, cell);
+	}
+	
+	template<class v_cell>
+	bool compute_indexed(int id, int fields, VoronoiCell& cell)
+	{
+		auto it = index.find(id);
+		if (it == index.end())
+			return false;
+		v_cell c;
+		const ParticleLocation& loc = it->second;
+		if (!compute_cell(*con, c, loc.ijk, loc.q))
+			return false;
+		const double* pp = con->p[loc.ijk] + con->ps * loc.q;
+		extract_cell(c, pp, fields, 0);
+		pack_cell(id, pp, 0, cell);
+		return true;
+	}
+	
+	// cells computed since the last change of their surroundings, the cell of a
+	// particle only changes if that particle is or becomes one of its neighbors
+	std::unordered_map<int, VoronoiCell> cache;
+	
+	// drops a particle and all of its current neighbors from the cache
+	void uncache_around(int id)
+	{
+		VoronoiCell cell;
+		auto it = cache.find(id);
+		if (it != cache.end())
+			cell = std::move(it->second);
+		else if (!compute_indexed(id, cell))
+		{
+			// without its own cell the neighbors of the particle are unknown
+			cache.clear();
+			return;
+		}
+		cache.erase(id);
+		for (int n : cell.neighbors)
+			cache.erase(n);
+	}
+	
+	// computes a particle's cell at its current position, caches it and drops its
+	// new neighbors from the cache
+	void cache_around(int id)
+	{
+		VoronoiCell cell;
+		if (!compute_indexed(id, cell))
+		{
+			cache.clear();
+			return;
+		}
+		for (int n : cell.neighbors)
+			cache.erase(n);
+		cache[id] = std::move(cell);
+	}
+	
+	// caches up to this many cells are scanned by uncache_inserted, for larger
+	// ones computing the cell of the inserted particle is cheaper
+	static const size_t cache_scan_limit = 256;
+	
+	// drops the cached cells that change by the insertion of a particle, which
+	// are those with a vertex at least as close to the new particle as to their
+	// own, by the power distance for particles with radii
+	void uncache_inserted(int id)
+	{
+		if (cache.size() > cache_scan_limit)
+		{
+			cache_around(id);
+			return;
+		}
+		const ParticleLocation& loc = index[id];
+		const double* pp = con->p[loc.ijk] + con->ps * loc.q;
+		double r = radius(loc);
+		const double period[3] = {con->bx - con->ax, con->by - con->ay, con->bz - con->az};
+		const bool periodic[3] = {con->xperiodic, con->yperiodic, con->zperiodic};
+		for (auto it = cache.begin(); it != cache.end();)
 		{
-			for (size_t j = 0; j < face.size(); ++j)
+			const VoronoiCell& cell = it->second;
+			auto own = index.find(cell.id);
+			double r_own = own != index.end() ? radius(own->second) : 0;
+			bool cut = false;
+			for (size_t v = 0; v < cell.vertices.size() && !cut; ++v)
 			{
-				int v1 = face[j];
-				int v2 = face[(j + 1) % face.size()];
-				// Sort to ensure uniqueness, e.g. (1, 2) is the same as (2, 1).
-				if (v1 > v2)
-					std::swap(v1, v2);
-				unique_edges.insert({v1, v2});
+				const Point3D& p = cell.vertices[v];
+				double d[3] = {p.x - pp[0], p.y - pp[1], p.z - pp[2]};
+				// the nearest periodic image of the new particle
+				for (int a = 0; a < 3; ++a)
+					if (periodic[a])
+						d[a] -= period[a] * std::round(d[a] / period[a]);
+				double ox = p.x - cell.position.x, oy = p.y - cell.position.y, oz = p.z - cell.position.z;
+				cut = d[0] * d[0] + d[1] * d[1] + d[2] * d[2] - r * r <= ox * ox + oy * oy + oz * oz - r_own * r_own;
 			}
+			it = cut ? cache.erase(it) : std::next(it);
+		}
+	}
+	
+	// walls of the container, which only stores pointers to them; batched walls
+	// are applied by the context instead of the container
+	struct OwnedWall
+	{
+		int handle;
+		std::unique_ptr<voro::wall> wall;
+		bool js;
+		bool batched;
+	};
+	std::vector<OwnedWall> owned_walls;
+	std::vector<WallJSBatched*> batched_walls;
+	int next_wall_handle = 0;
+	
+	// adds a wall to the container and takes ownership of it, returns its handle
+	int add_owned_wall(voro::wall* w, bool js = false)
+	{
+		owned_walls.push_back({next_wall_handle, std::unique_ptr<voro::wall>(w), js, false});
+		con->add_wall(*w);
+		// JavaScript can only be called from the main thread.
+		if (js)
+			++js_walls;
+		cache.clear();
+		cancel_chunk();
+		return next_wall_handle++;
+	}
+	
+	// precision of the flat outputs, with their single precision arrays
+	bool single_precision = false;
+	bool relative_vertices = false;
+	VoronoiCellsFlat32 flat32, chunk_flat32;
+	
+	// statistics of the main thread, into which those of the workers are merged
+	bool stats_enabled = false;
+	ContextStats stats;
+	
+	void collect_stats()
+	{
+		for (ComputeWorker& w : workers)
+		{
+			stats.add(w.stats);
+			w.stats = ContextStats();
+		}
+	}
+	
+	// convert the output to JavaScript, counting the bytes of its numbers; an
+	// incremental conversion only converts the cells appended to f since the
+	// last one into single precision
+	emscripten::val flat_to_js(const VoronoiCellsFlat& f, VoronoiCellsFlat32& single, bool incremental = false)
+	{
+		PhaseTimer timer(stats_enabled ? &stats.convert_ms : nullptr);
+		if (!single_precision)
+		{
+			if (stats_enabled)
+				stats.bytes_emitted += f.bytes();
+			return flatToJS(f);
+		}
+		if (incremental)
+			single.append_from(f, relative_vertices);
+		else
+			single.assign(f, relative_vertices);
+		// the doubles are replaced by floats of half their size
+		if (stats_enabled)
+			stats.bytes_emitted += f.bytes() - single.bytes();
+		return flatToJS(f, &single);
+	}
+	
+	emscripten::val cell_to_js(const VoronoiCell& c)
+	{
+		PhaseTimer timer(stats_enabled ? &stats.convert_ms : nullptr);
+		if (stats_enabled)
+		{
+			size_t ints = 1 + 2 * c.edges.size() + c.neighbors.size();
+			for (const std::vector<int>& face : c.faces)
+				ints += face.size();
+			stats.bytes_emitted += sizeof(int) * ints + sizeof(double) * (4 + 3 * c.vertices.size());
+		}
+		return cellToJS(c);
+	}
+	
+	// number of threads for computing cells and their output buffers
+	int threads = default_threads();
+	std::vector<ComputeWorker> workers = std::vector<ComputeWorker>(1);
+	// number of JavaScript walls, which prevent computing cells on other threads
+	int js_walls = 0;
+	// voro++ keeps the radius of the particle whose cell is computed in a
+	// container for particles with radii, which therefore computes one cell at a time
+	static constexpr bool concurrent = !std::is_base_of<voro::radius_poly, c_class>::value;
+	
+	static int default_threads()
+	{
+#ifdef VOROJS_THREADS
+		int n = static_cast<int>(std::thread::hardware_concurrency());
+		return std::max(1, std::min(n, max_threads));
+#else
+		return 1;
+#endif
+	}
+	
+	// runs fn(thread, ijk_begin, ijk_end) on ranges of consecutive blocks, one
+	// range per thread, with roughly the same number of particles in each range;
+	// the ranges are ordered by thread such that results can be merged in order
+	template<class F>
+	void for_each_block_range(F fn)
+	{
+		update_grid();
+		int n_threads = js_walls > 0 || !concurrent ? 1 : threads;
+		int total = con->total_particles();
+		if (total < 64 * n_threads)
+			n_threads = 1;
+		if (workers.size() != static_cast<size_t>(n_threads))
+		{
+			collect_stats();
+			workers.resize(n_threads);
+		}
+		prepare_batched_walls(bulk_rows);
+		batched_rows = &bulk_rows;
+		if (n_threads == 1)
+			fn(0, 0, con->nxyz);
+		else
+			run_block_ranges(fn, n_threads, total);
+		batched_rows = nullptr;
+	}
+	
+	template<class F>
+	void run_block_ranges(F& fn, int n_threads, int total)
+	{
+#ifdef VOROJS_THREADS
+		// split the blocks at multiples of total / n_threads particles
+		std::vector<int> bounds(n_threads + 1, con->nxyz);
+		bounds[0] = 0;
+		int count = 0, t = 1;
+		for (int ijk = 0; ijk < con->nxyz && t < n_threads; ++ijk)
+		{
+			count += con->co[ijk];
+			while (t < n_threads && count >= static_cast<long long>(total) * t / n_threads)
+				bounds[t++] = ijk + 1;
+		}
+		std::vector<std::thread> pool;
+		for (t = 1; t < n_threads; ++t)
+			pool.emplace_back(fn, t, bounds[t], bounds[t + 1]);
+		fn(0, bounds[0], bounds[1]);
+		for (std::thread& thread : pool)
+			thread.join();
+#endif
+	}
+	
+	// rows of the batched walls for all particles, one array per wall, where
+	// the row of particle q in block ijk is found at the particle count of all
+	// previous blocks plus q
+	struct BatchedRows
+	{
+		std::vector<int> block_offsets;
+		std::vector<double> positions;
+		std::vector<std::vector<double>> rows;
+	};
+	// the rows of the bulk queries and of the chunked computation, which are kept
+	// apart as bulk queries may run between the chunks
+	BatchedRows bulk_rows, chunk_rows;
+	// the rows used by compute_cell, without them each cell calls JavaScript
+	const BatchedRows* batched_rows = nullptr;
+	
+	// calls each batched wall once with the positions of all particles
+	void prepare_batched_walls(BatchedRows& br)
+	{
+		if (batched_walls.empty())
+			return;
+		br.block_offsets.resize(con->nxyz);
+		br.positions.clear();
+		for (int ijk = 0; ijk < con->nxyz; ++ijk)
+		{
+			br.block_offsets[ijk] = static_cast<int>(br.positions.size() / 3);
+			for (int q = 0; q < con->co[ijk]; ++q)
+				br.positions.insert(br.positions.end(), con->p[ijk] + con->ps * q, con->p[ijk] + con->ps * q + 3);
+		}
+		br.rows.resize(batched_walls.size());
+		for (size_t w = 0; w < batched_walls.size(); ++w)
+			batched_walls[w]->prepare(br.positions, br.rows[w]);
+	}
+	
+	// computes the cell of particle q in block ijk with the given computer, which
+	// applies the walls of the container, and cuts it by the batched walls
+	template<class computer_t, class v_cell>
+	bool compute_cell(computer_t& computer, v_cell& c, int ijk, int q, int t = 0)
+	{
+		ContextStats* st = stats_enabled ? &workers[t].stats : nullptr;
+		PhaseTimer timer(st ? &st->compute_ms : nullptr);
+		bool computed = computer.compute_cell(c, ijk, q) && cut_batched(c, ijk, q);
+		if (st)
+			++(computed ? st->cells_computed : st->cells_failed);
+		return computed;
+	}
+	
+	template<class v_cell>
+	bool cut_batched(v_cell& c, int ijk, int q)
+	{
+		const double* pp = con->p[ijk] + con->ps * q;
+		for (size_t w = 0; w < batched_walls.size(); ++w)
+		{
+			WallJSBatched* wall = batched_walls[w];
+			if (!(batched_rows ? wall->apply(c, batched_rows->rows[w], batched_rows->block_offsets[ijk] + q) : wall->cut_cell(c, pp[0], pp[1], pp[2])))
+				return false;
 		}
-		// Convert the unique edges set back to a vector<vector<int>>.
-		cell.edges.assign(unique_edges.begin(), unique_edges.end());
+		return true;
+	}
+	
+	// extracts the given fields of a computed cell into the scratch buffers of thread t
+	template<class v_cell>
+	void extract_cell(v_cell& c, const double* pp, int fields, int t)
+	{
+		PhaseTimer timer(stats_enabled ? &workers[t].stats.extract_ms : nullptr);
+		extract_cell_data(c, pp[0], pp[1], pp[2], fields, workers[t].scratch);
+	}
+	
+	// packs the cell extracted by thread t into a cell or the flat output
+	void pack_cell(int id, const double* pp, int t, VoronoiCell& cell)
+	{
+		PhaseTimer timer(stats_enabled ? &workers[t].stats.pack_ms : nullptr);
+		scratch_to_cell(id, pp[0], pp[1], pp[2], workers[t].scratch, cell);
+	}
+	
+	void pack_cell(int id, const double* pp, int fields, int t, VoronoiCellsFlat& out)
+	{
+		PhaseTimer timer(stats_enabled ? &workers[t].stats.pack_ms : nullptr);
+		append_cell_flat(id, pp[0], pp[1], pp[2], fields, workers[t].scratch, out);
+	}
+	
+	// staging buffers for bulk insertion from typed arrays
+	std::vector<int> staging_ids;
+	std::vector<double> staging_coords;
+	
+	// flat output buffers, reused between computations
+	VoronoiCellsFlat flat;
+	NeighborGraph graph;
+	RenderMesh mesh;
+	VoronoiCellsFlat wire_flat;
+	WireframeBuilder wireframe;
+	std::vector<int> located;
+	// centroids of the cells for relaxation, kept apart from the flat output
+	VoronoiCellsFlat relax_flat;
+	
+	// state of the chunked computation: the next particle q in block ijk, and
+	// the cells computed so far
+	bool chunk_active = false;
+	int chunk_fields = CELL_ALL;
+	int chunk_ijk = 0, chunk_q = 0;
+	VoronoiCellsFlat chunk_flat;
+	
+	// computes cells of a chunked computation from where the last chunk stopped,
+	// with the batched walls cut by the rows prepared at its start
+	template<class v_cell>
+	void compute_chunk(int max_cells, double max_millis)
+	{
+		batched_rows = &chunk_rows;
+		chunk_active = !compute_chunk_cells<v_cell>(max_cells, max_millis);
+		batched_rows = nullptr;
+	}
+	
+	// returns true once all cells are computed
+	template<class v_cell>
+	bool compute_chunk_cells(int max_cells, double max_millis)
+	{
+		// the clock is only read if there is a time limit
+		double start = max_millis > 0 ? now_ms() : 0;
+		v_cell c;
+		int computed = 0;
+		for (; chunk_ijk < con->nxyz; ++chunk_ijk, chunk_q = 0)
+			for (; chunk_q < con->co[chunk_ijk]; ++chunk_q)
+			{
+				if (computed > 0)
+				{
+					if (max_cells > 0 && computed >= max_cells)
+						return false;
+					if (max_millis > 0 && now_ms() - start >= max_millis)
+						return false;
+				}
+				++computed;
+				if (compute_cell(*con, c, chunk_ijk, chunk_q))
+				{
+					const double* pp = con->p[chunk_ijk] + con->ps * chunk_q;
+					extract_cell(c, pp, chunk_fields, 0);
+					pack_cell(con->id[chunk_ijk][chunk_q], pp, chunk_fields, 0, chunk_flat);
+				}
+			}
+		return true;
+	}
+	
+	// stops a chunked computation, as its cells and prepared rows of the batched
+	// walls no longer match the context after a change
+	void cancel_chunk()
+	{
+		chunk_active = false;
+		chunk_flat.clear();
+		chunk_flat32.clear();
+	}
+	
+	// computes all cells with the given fields, complete cells are looked up in
+	// and added to the cache
+	template<class v_cell>
+	std::vector<VoronoiCell> compute_cells(int fields)
+	{
+		bool caching = fields == CELL_ALL;
+		for_each_block_range([this, fields, caching](int t, int ijk_begin, int ijk_end) {
+			std::vector<VoronoiCell>& cells = workers[t].cells;
+			std::vector<bool>& computed = workers[t].computed;
+			cells.clear();
+			computed.clear();
+			CellComputer<c_class> computer(*con);
+			v_cell c;
+			for (int ijk = ijk_begin; ijk < ijk_end; ++ijk)
+				for (int q = 0; q < con->co[ijk]; ++q)
+				{
+					// reuse the cell if it is still valid from a previous computation
+					int id = con->id[ijk][q];
+					auto it = caching ? cache.find(id) : cache.end();
+					if (it != cache.end())
+					{
+						cells.push_back(it->second);
+						computed.push_back(false);
+					}
+					// compute the cell for the current particle
+					else if (compute_cell(computer, c, ijk, q, t))
+					{
+						// extract the requested properties from voro++
+						const double* pp = con->p[ijk] + con->ps * q;
+						extract_cell(c, pp, fields, t);
+						cells.emplace_back();
+						pack_cell(id, pp, t, cells.back());
+						computed.push_back(caching);
+					}
+				}
+		});
 		
-		// Get cell neighbors, these are updated by call by reference.
-		c.neighbors(cell.neighbors);
-		return;
+		// merge the cells of all threads and add new ones to the cache
+		std::vector<VoronoiCell> cells;
+		for (ComputeWorker& w : workers)
+			for (size_t i = 0; i < w.cells.size(); ++i)
+			{
+				if (w.computed[i])
+					cache.emplace(w.cells[i].id, w.cells[i]);
+				cells.push_back(std::move(w.cells[i]));
+			}
+		return cells;
+	}
+	
+	// computes all cells with the given fields into flat output buffers
+	template<class v_cell>
+	void compute_flat(int fields, VoronoiCellsFlat& result)
+	{
+		result.clear();
+		for_each_block_range([this, fields, &result](int t, int ijk_begin, int ijk_end) {
+			// the first thread writes to the output directly
+			VoronoiCellsFlat& out = t == 0 ? result : workers[t].flat;
+			out.clear();
+			CellComputer<c_class> computer(*con);
+			v_cell c;
+			for (int ijk = ijk_begin; ijk < ijk_end; ++ijk)
+				for (int q = 0; q < con->co[ijk]; ++q)
+					if (compute_cell(computer, c, ijk, q, t))
+					{
+						const double* pp = con->p[ijk] + con->ps * q;
+						extract_cell(c, pp, fields, t);
+						pack_cell(con->id[ijk][q], pp, fields, t, out);
+					}
+		});
+		for (size_t t = 1; t < workers.size(); ++t)
+			result.append(workers[t].flat);
+	}
+	
+	// computes the neighbor graph of all cells into graph
+	void compute_graph(bool with_areas)
+	{
+		graph.clear();
+		for_each_block_range([this, with_areas](int t, int ijk_begin, int ijk_end) {
+			// the first thread writes to the output directly
+			NeighborGraph& out = t == 0 ? graph : workers[t].graph;
+			out.clear();
+			CellComputer<c_class> computer(*con);
+			voro::voronoicell_neighbor c;
+			for (int ijk = ijk_begin; ijk < ijk_end; ++ijk)
+				for (int q = 0; q < con->co[ijk]; ++q)
+					if (compute_cell(computer, c, ijk, q, t))
+					{
+						PhaseTimer timer(stats_enabled ? &workers[t].stats.pack_ms : nullptr);
+						append_cell_graph(con->id[ijk][q], c, with_areas, workers[t].scratch, out);
+					}
+		});
+		for (size_t t = 1; t < workers.size(); ++t)
+			graph.append(workers[t].graph);
+	}
+	
+	// computes the render mesh of all cells into mesh
+	void compute_mesh(bool flat_normals, double shrink)
+	{
+		mesh.clear();
+		for_each_block_range([this, flat_normals, shrink](int t, int ijk_begin, int ijk_end) {
+			// the first thread writes to the output directly
+			RenderMesh& out = t == 0 ? mesh : workers[t].mesh;
+			out.clear();
+			CellComputer<c_class> computer(*con);
+			voro::voronoicell c;
+			for (int ijk = ijk_begin; ijk < ijk_end; ++ijk)
+				for (int q = 0; q < con->co[ijk]; ++q)
+					if (compute_cell(computer, c, ijk, q, t))
+					{
+						PhaseTimer timer(stats_enabled ? &workers[t].stats.pack_ms : nullptr);
+						const double* pp = con->p[ijk] + con->ps * q;
+						append_cell_mesh(con->id[ijk][q], c, pp[0], pp[1], pp[2], flat_normals, shrink, workers[t].scratch, out);
+					}
+		});
+		for (size_t t = 1; t < workers.size(); ++t)
+			mesh.append(workers[t].mesh);
+	}
+	
+	// computes the cells of the staged ids with the given fields into the flat
+	// output buffers
+	template<class v_cell>
+	void compute_ids_flat(int fields)
+	{
+		v_cell c;
+		for (int id : staging_ids)
+		{
+			auto it = index.find(id);
+			if (it == index.end())
+				continue;
+			const ParticleLocation& loc = it->second;
+			if (compute_cell(*con, c, loc.ijk, loc.q))
+			{
+				const double* pp = con->p[loc.ijk] + con->ps * loc.q;
+				extract_cell(c, pp, fields, 0);
+				pack_cell(id, pp, fields, 0, flat);
+			}
+		}
+	}
+};
+
+// contexts for particles without and with radii, the latter computing the
+// radical (power) tessellation
+typedef VoronoiContext<voro::container> VoronoiContext3D;
+typedef VoronoiContext<voro::container_poly> VoronoiContextPoly3D;
+
+/** \brief A C++ class that binds a periodic voro++ container to Javascript.
+ *
+ * The container is the parallelepiped spanned by (bx, 0, 0), (bxy, by, 0) and
+ * (bxz, byz, bz) with its origin at (0, 0, 0), periodic along all three axes, so
+ * triclinic simulation boxes are tessellated without ghost particles. Particles
+ * can only be added, walls, moving or removing particles and threads are not
+ * supported by this container.
+ */
+class VoronoiContextPeriodic3D
+{
+public:
+	// Constructor: initializes a periodic 3D Voro++ container
+	// Parameters define the box vectors and the number of blocks per axis
+	VoronoiContextPeriodic3D(double bx, double bxy, double by, double bxz, double byz, double bz, int n_x, int n_y, int n_z)
+		: con(bx, bxy, by, bxz, byz, bz, n_x, n_y, n_z, 8) {}
+	
+	// adds a single 3d point to the container, points outside of the box are
+	// moved into it by the periodicity
+	void addPoint(int id, double x, double y, double z)
+	{
+		put_indexed(id, x, y, z);
+	}
+	
+	// adds multiple 3d points from an Int32Array of ids and an interleaved Float64Array [x1, y1, z1, ...]
+	void addPointsFlat(emscripten::val ids, emscripten::val xyz)
+	{
+		typedArrayToVector(ids, staging_ids);
+		typedArrayToVector(xyz, staging_coords);
+		if (3 * staging_ids.size() != staging_coords.size()) {
+			throw std::runtime_error(std::string("addPointsFlat failed because of mismatch in ids and xyz sizes"));
+		}
+		for (size_t i = 0; i < staging_ids.size(); ++i)
+			put_indexed(staging_ids[i], staging_coords[3 * i], staging_coords[3 * i + 1], staging_coords[3 * i + 2]);
+	}
+	
+	// computes and returns all Voronoi cells as JS objects
+	emscripten::val getCells()
+	{
+		return getCells(CELL_ALL);
+	}
+	
+	// computes and returns all Voronoi cells as JS objects with only the given fields
+	emscripten::val getCells(int fields)
+	{
+		if (fields & CELL_NEIGHBORS)
+			compute_flat<voro::voronoicell_neighbor>(fields, true);
+		else
+			compute_flat<voro::voronoicell>(fields, true);
+		emscripten::val js_cells = emscripten::val::array();
+		for (const auto& c : cells) {
+			js_cells.call<void>("push", cellToJS(c));
+		}
+		return js_cells;
+	}
+	
+	// computes all Voronoi cells and returns them as typed array views, the
+	// views are reused by the next call
+	emscripten::val getCellsFlat()
+	{
+		return getCellsFlat(CELL_ALL);
+	}
+	
+	emscripten::val getCellsFlat(int fields)
+	{
+		if (fields & CELL_NEIGHBORS)
+			compute_flat<voro::voronoicell_neighbor>(fields, false);
+		else
+			compute_flat<voro::voronoicell>(fields, false);
+		return flatToJS(flat);
+	}
+	
+	// computes and returns a specific Voronoi cell by its ID as a JS object,
+	// unknown IDs give an empty cell
+	emscripten::val getCellById(int id)
+	{
+		return getCellById(id, CELL_ALL);
+	}
+	
+	emscripten::val getCellById(int id, int fields)
+	{
+		VoronoiCell cell;
+		auto it = index.find(id);
+		if (it != index.end())
+		{
+			if (fields & CELL_NEIGHBORS)
+				compute_indexed<voro::voronoicell_neighbor>(id, it->second, fields, cell);
+			else
+				compute_indexed<voro::voronoicell>(id, it->second, fields, cell);
+		}
+		return cellToJS(cell);
+	}
+	
+	// clears all particles from the container
+	void clear()
+	{
+		con.clear();
+		index.clear();
+	}
+
+private:
+	// periodic container of voro++ library
+	voro::container_periodic con;
+	
+	// index from particle id to its location in the container
+	std::unordered_map<int, ParticleLocation> index;
+	voro::particle_order order;
+	
+	// staging, scratch and output buffers, reused between calls
+	std::vector<int> staging_ids;
+	std::vector<double> staging_coords;
+	ExtractScratch scratch;
+	VoronoiCellsFlat flat;
+	std::vector<VoronoiCell> cells;
+	
+	// inserts a particle and records where the container stored it, returns
+	// false if the container did not store it
+	bool put_indexed(int id, double x, double y, double z)
+	{
+		// the particle order is only used to report the location of this insertion
+		order.op = order.o;
+		con.put(order, id, x, y, z);
+		if (order.op == order.o)
+			return false;
+		index[id] = {order.o[0], order.o[1]};
+		return true;
+	}
+	
+	// computes all cells of the primary domain with the given fields into the
+	// cell objects or the flat output buffers
+	template<class v_cell>
+	void compute_flat(int fields, bool as_cells)
+	{
+		flat.clear();
+		cells.clear();
+		// the loop only visits the particles of the primary domain, not their images
+		voro::c_loop_all_periodic cla(con);
+		v_cell c;
+		if (cla.start())
+		{
+			do {
+				if (con.compute_cell(c, cla))
+				{
+					double x, y, z;
+					cla.pos(x, y, z);
+					extract_cell_data(c, x, y, z, fields, scratch);
+					if (as_cells)
+					{
+						cells.emplace_back();
+						scratch_to_cell(cla.pid(), x, y, z, scratch, cells.back());
+					}
+					else
+						append_cell_flat(cla.pid(), x, y, z, fields, scratch, flat);
+				}
+			} while (cla.inc());
+		}
+	}
+	
+	template<class v_cell>
+	void compute_indexed(int id, const ParticleLocation& loc, int fields, VoronoiCell& cell)
+	{
+		v_cell c;
+		if (!con.compute_cell(c, loc.ijk, loc.q))
+			return;
+		const double* pp = con.p[loc.ijk] + 3 * loc.q;
+		extract_cell_data(c, pp[0], pp[1], pp[2], fields, scratch);
+		scratch_to_cell(id, pp[0], pp[1], pp[2], scratch, cell);
 	}
 };
 
@@ -444,57 +2076,19 @@ public:
 	 */
 	VoronoiCell getCellRaw()
 	{
-		VoronoiCell voronoi_cell;
-		
+		return getCellRaw(CELL_ALL);
+	}
+	
+	/** \brief Gets the given fields of the Voronoi cell.
+	 * \param[in] fields the CellField flags to extract.
+	 * \return The Voronoi cell in VoronoiCell format.
+	 */
+	VoronoiCell getCellRaw(int fields)
+	{
 		// Assume cell position equals (0, 0, 0) and id defaults to 0.
-		voronoi_cell.position = {0, 0, 0};
-		voronoi_cell.id = 0;
-		voronoi_cell.volume = cell.volume();
-		
-		// Get cell vertices, these are updated by call by reference.
-		std::vector<double> v;
-		cell.vertices(voronoi_cell.position.x, voronoi_cell.position.y, voronoi_cell.position.z, v);
-		// Then convert the vertices from [x1, y1, z1, ...] to vector<Point3D>.
-		for (size_t i = 0; i < v.size(); i += 3)
-			voronoi_cell.vertices.push_back({v[i], v[i+1], v[i+2]});
-			
-		// Get cell faces and orders, these are updated by call by reference.
-		std::vector<int> face_vertices, face_orders;
-		cell.face_vertices(face_vertices);
-		cell.face_orders(face_orders);
-		
-		// Then convert these two vectors to a vector of vector of ints where
-		// each vector contains the vertex numbers corresponding to a face.
-		// The order contains the number of vertices for the indexed face.
-		int fv_offset = 0;
-		for (int fv_cnt : face_orders)
-		{
-			std::vector<int> current_face;
-			current_face.reserve(fv_cnt);
-			// The structure of cell.face_vertices is [f1#, f1_v1, f1v2, ... fn#, fn_v1, ...]
-			for (int j = 1; j <= fv_cnt; ++j)
-				current_face.push_back(face_vertices[fv_offset + j]);
-			voronoi_cell.faces.push_back(current_face);
-			fv_offset += (fv_cnt + 1);
-		}
-		
-		// Extract unique edges from the face data.
-		std::set<std::vector<int>> unique_edges;
-		for (const auto& face : voronoi_cell.faces)
-		{
-			for (size_t j = 0; j < face.size(); ++j)
-			{
-				int v1 = face[j];
-				int v2 = face[(j + 1) % face.size()];
-				// Sort to ensure uniqueness, e.g. (1, 2) is the same as (2, 1).
-				if (v1 > v2)
-					std::swap(v1, v2);
-				unique_edges.insert({v1, v2});
-			}
-		}
-		// Convert the unique edges set back to a vector<vector<int>>.
-		voronoi_cell.edges.assign(unique_edges.begin(), unique_edges.end());
-		
+		VoronoiCell voronoi_cell;
+		extract_cell_data(cell, 0, 0, 0, fields, scratch);
+		scratch_to_cell(0, 0, 0, 0, scratch, voronoi_cell);
 		return voronoi_cell;
 	}
 
@@ -503,13 +2097,83 @@ public:
 	{
 		return cellToJS(getCellRaw());
 	}
+	
+	emscripten::val getCell(int fields)
+	{
+		return cellToJS(getCellRaw(fields));
+	}
 
 private:
 	// The cell is stored in this binding class.
 	voro::voronoicell cell;
+	// Reused buffers for extracting the cell.
+	ExtractScratch scratch;
 };
 
 
+/** \brief Binds the constructors and methods shared by the contexts for
+ * particles without and with radii, which differ in how particles are added.
+ */
+template<class context_t>
+void bind_context(const emscripten::class_<context_t>& cls)
+{
+	cls
+		.template constructor<double, double, double, double, double, double>()
+		.template constructor<double, double, double, double, double, double, int>()
+		.template constructor<double, double, double, double, double, double, int, int, int>()
+		.template constructor<double, double, double, double, double, double, int, bool, bool, bool>()
+		.template constructor<double, double, double, double, double, double, int, int, int, bool, bool, bool>()
+		.function("movePoint", &context_t::movePoint)
+		.function("removePoint", &context_t::removePoint)
+		.function("addWallPlane", &context_t::addWallPlane)
+		.function("addWallPlanes", &context_t::addWallPlanes)
+		.function("addWallSphere", &context_t::addWallSphere)
+		.function("addWallCylinder", &context_t::addWallCylinder)
+		.function("addWallCone", &context_t::addWallCone)
+		.function("addWallJS", &context_t::addWallJS)
+		.function("addWallJSBatched", &context_t::addWallJSBatched)
+		.function("addWallSDF", &context_t::addWallSDF)
+		.function("removeWall", &context_t::removeWall)
+		.function("clearWalls", &context_t::clearWalls)
+		.function("getCellsRaw", emscripten::select_overload<std::vector<VoronoiCell>()>(&context_t::getCellsRaw))
+		.function("getCellsRaw", emscripten::select_overload<std::vector<VoronoiCell>(int)>(&context_t::getCellsRaw))
+		.function("getCells", emscripten::select_overload<emscripten::val()>(&context_t::getCells))
+		.function("getCells", emscripten::select_overload<emscripten::val(int)>(&context_t::getCells))
+		.function("getCellsFlat", emscripten::select_overload<emscripten::val()>(&context_t::getCellsFlat))
+		.function("getCellsFlat", emscripten::select_overload<emscripten::val(int)>(&context_t::getCellsFlat))
+		.function("getCellRawById", emscripten::select_overload<VoronoiCell(int)>(&context_t::getCellRawById))
+		.function("getCellRawById", emscripten::select_overload<VoronoiCell(int, int)>(&context_t::getCellRawById))
+		.function("getCellById", emscripten::select_overload<emscripten::val(int)>(&context_t::getCellById))
+		.function("getCellById", emscripten::select_overload<emscripten::val(int, int)>(&context_t::getCellById))
+		.function("getCellsByIds", emscripten::select_overload<emscripten::val(emscripten::val)>(&context_t::getCellsByIds))
+		.function("getCellsByIds", emscripten::select_overload<emscripten::val(emscripten::val, int)>(&context_t::getCellsByIds))
+		.function("getNeighborGraph", emscripten::select_overload<emscripten::val()>(&context_t::getNeighborGraph))
+		.function("getNeighborGraph", emscripten::select_overload<emscripten::val(bool)>(&context_t::getNeighborGraph))
+		.function("getRenderMesh", emscripten::select_overload<emscripten::val()>(&context_t::getRenderMesh))
+		.function("getRenderMesh", emscripten::select_overload<emscripten::val(emscripten::val)>(&context_t::getRenderMesh))
+		.function("getWireframe", &context_t::getWireframe)
+		.function("locatePoints", &context_t::locatePoints)
+		.function("beginCompute", emscripten::select_overload<void()>(&context_t::beginCompute))
+		.function("beginCompute", emscripten::select_overload<void(int)>(&context_t::beginCompute))
+		.function("computeChunk", emscripten::select_overload<emscripten::val(int)>(&context_t::computeChunk))
+		.function("computeChunk", emscripten::select_overload<emscripten::val(int, double)>(&context_t::computeChunk))
+		.function("isDone", &context_t::isDone)
+		.function("cancelCompute", &context_t::cancelCompute)
+		.function("relaxVoronoi", &context_t::relaxVoronoi)
+		.function("relax", emscripten::select_overload<emscripten::val(int)>(&context_t::relax))
+		.function("relax", emscripten::select_overload<emscripten::val(int, double)>(&context_t::relax))
+		.function("setThreads", &context_t::setThreads)
+		.function("getThreads", &context_t::getThreads)
+		.function("getGrid", &context_t::getGrid)
+		.function("setSortedInsert", &context_t::setSortedInsert)
+		.function("setPrecision", emscripten::select_overload<void(int)>(&context_t::setPrecision))
+		.function("setPrecision", emscripten::select_overload<void(int, bool)>(&context_t::setPrecision))
+		.function("setStatsEnabled", &context_t::setStatsEnabled)
+		.function("getStats", &context_t::getStats)
+		.function("resetStats", &context_t::resetStats)
+		.function("clear", &context_t::clear);
+}
+
 /** \brief Emscripten bindings.
  *
  * This binds all C++ code to Javascript.
@@ -530,27 +2194,45 @@ EMSCRIPTEN_BINDINGS(voro_module_3d)
 		.field("faces", &VoronoiCell::faces)
 		.field("neighbors", &VoronoiCell::neighbors);
 
+	emscripten::constant("CELL_VOLUME", static_cast<int>(CELL_VOLUME));
+	emscripten::constant("CELL_VERTICES", static_cast<int>(CELL_VERTICES));
+	emscripten::constant("CELL_FACES", static_cast<int>(CELL_FACES));
+	emscripten::constant("CELL_EDGES", static_cast<int>(CELL_EDGES));
+	emscripten::constant("CELL_NEIGHBORS", static_cast<int>(CELL_NEIGHBORS));
+	emscripten::constant("CELL_ALL", static_cast<int>(CELL_ALL));
+
 	emscripten::register_vector<Point3D>("VectorPoint3D");
 	emscripten::register_vector<VoronoiCell>("VectorVoronoiCell");
 	emscripten::register_vector<int>("VectorInt");
 	emscripten::register_vector<double>("VectorDouble");
 	emscripten::register_vector<std::vector<int>>("VectorVectorInt");
 
-	emscripten::class_<VoronoiContext3D>("VoronoiContext3D")
-		.constructor<double, double, double, double, double, double, int, int, int>()
-		.function("addPoint", &VoronoiContext3D::addPoint)
+	emscripten::class_<VoronoiContext3D> context_3d("VoronoiContext3D");
+	bind_context(context_3d);
+	context_3d
+		.function("addPoint", emscripten::select_overload<void(int, double, double, double)>(&VoronoiContext3D::addPoint))
 		.function("addPoints", &VoronoiContext3D::addPoints)
-		.function("addWallPlane", &VoronoiContext3D::addWallPlane)
-		.function("addWallSphere", &VoronoiContext3D::addWallSphere)
-		.function("addWallCylinder", &VoronoiContext3D::addWallCylinder)
-		.function("addWallCone", &VoronoiContext3D::addWallCone)
-		.function("addWallJS", &VoronoiContext3D::addWallJS)
-		.function("getCellsRaw", &VoronoiContext3D::getCellsRaw)
-		.function("getCells", &VoronoiContext3D::getCells)
-		.function("getCellRawById", &VoronoiContext3D::getCellRawById)
-		.function("getCellById", &VoronoiContext3D::getCellById)
-		.function("relaxVoronoi", &VoronoiContext3D::relaxVoronoi)
-		.function("clear", &VoronoiContext3D::clear);
+		.function("addPointsFlat", emscripten::select_overload<void(emscripten::val, emscripten::val)>(&VoronoiContext3D::addPointsFlat))
+		.function("addPointsSoA", emscripten::select_overload<void(emscripten::val, emscripten::val, emscripten::val, emscripten::val)>(&VoronoiContext3D::addPointsSoA));
+	
+	emscripten::class_<VoronoiContextPoly3D> context_poly_3d("VoronoiContextPoly3D");
+	bind_context(context_poly_3d);
+	context_poly_3d
+		.function("addPoint", emscripten::select_overload<void(int, double, double, double, double)>(&VoronoiContextPoly3D::addPoint))
+		.function("addPointsFlat", emscripten::select_overload<void(emscripten::val, emscripten::val, emscripten::val)>(&VoronoiContextPoly3D::addPointsFlat))
+		.function("addPointsSoA", emscripten::select_overload<void(emscripten::val, emscripten::val, emscripten::val, emscripten::val, emscripten::val)>(&VoronoiContextPoly3D::addPointsSoA));
+	
+	emscripten::class_<VoronoiContextPeriodic3D>("VoronoiContextPeriodic3D")
+		.constructor<double, double, double, double, double, double, int, int, int>()
+		.function("addPoint", &VoronoiContextPeriodic3D::addPoint)
+		.function("addPointsFlat", &VoronoiContextPeriodic3D::addPointsFlat)
+		.function("getCells", emscripten::select_overload<emscripten::val()>(&VoronoiContextPeriodic3D::getCells))
+		.function("getCells", emscripten::select_overload<emscripten::val(int)>(&VoronoiContextPeriodic3D::getCells))
+		.function("getCellsFlat", emscripten::select_overload<emscripten::val()>(&VoronoiContextPeriodic3D::getCellsFlat))
+		.function("getCellsFlat", emscripten::select_overload<emscripten::val(int)>(&VoronoiContextPeriodic3D::getCellsFlat))
+		.function("getCellById", emscripten::select_overload<emscripten::val(int)>(&VoronoiContextPeriodic3D::getCellById))
+		.function("getCellById", emscripten::select_overload<emscripten::val(int, int)>(&VoronoiContextPeriodic3D::getCellById))
+		.function("clear", &VoronoiContextPeriodic3D::clear);
 		
 	emscripten::class_<VoronoiCell3D>("VoronoiCell3D")
 		.constructor<>()
@@ -558,6 +2240,8 @@ EMSCRIPTEN_BINDINGS(voro_module_3d)
 		.function("updateBox", &VoronoiCell3D::updateBox)
 		.function("cutPlane", &VoronoiCell3D::cutPlane)
 		.function("cutPlaneR", &VoronoiCell3D::cutPlaneR)
-		.function("getCellRaw", &VoronoiCell3D::getCellRaw)
-		.function("getCell", &VoronoiCell3D::getCell);
+		.function("getCellRaw", emscripten::select_overload<VoronoiCell()>(&VoronoiCell3D::getCellRaw))
+		.function("getCellRaw", emscripten::select_overload<VoronoiCell(int)>(&VoronoiCell3D::getCellRaw))
+		.function("getCell", emscripten::select_overload<emscripten::val()>(&VoronoiCell3D::getCell))
+		.function("getCell", emscripten::select_overload<emscripten::val(int)>(&VoronoiCell3D::getCell));
 }
@@ -0,0 +1,84 @@
+// Worker of createVoroWorkerPool, running in a Web Worker or a Node worker
+// thread. It instantiates the module compiled by the main thread and
+// tessellates one container per message.
+// @ts-ignore: This file is generated during the build process.
+import createVoroModule from './REPLACE_ME.js';
+import type { TessellateOptions } from './index.js';
+
+type Reply = (message: any, transfer: ArrayBuffer[]) => void;
+
+let Module: any = null;
+
+// Instantiates the compiled module instead of loading the WebAssembly file again.
+async function init(module: WebAssembly.Module): Promise<void>
+{
+	Module = await createVoroModule({
+		instantiateWasm(imports: WebAssembly.Imports, receive: (instance: WebAssembly.Instance, module: WebAssembly.Module) => void) {
+			WebAssembly.instantiate(module, imports).then((instance) => receive(instance, module));
+			return {};
+		}
+	});
+}
+
+// Tessellates a container and copies the flat output out of the heap.
+function tessellate(points: Float64Array, options: TessellateOptions): any
+{
+	// checked here since an exception of the module would abort it
+	if (points.length % 3 !== 0 || (options.ids && options.ids.length !== points.length / 3))
+		throw new Error('tessellate failed because of mismatch in ids and points sizes');
+	const n = points.length / 3;
+	const ids = options.ids ?? Int32Array.from({ length: n }, (_, i) => i);
+	const periodic = options.periodic ?? [false, false, false];
+	const Context = options.radii ? Module.VoronoiContextPoly3D : Module.VoronoiContext3D;
+	const context = options.grid
+		? new Context(...options.bounds, ...options.grid, ...periodic)
+		: new Context(...options.bounds, n, ...periodic);
+	try {
+		if (options.radii)
+			context.addPointsFlat(ids, points, options.radii);
+		else
+			context.addPointsFlat(ids, points);
+		const flat = context.getCellsFlat(options.fields ?? Module.CELL_ALL);
+		const result: any = { count: flat.count };
+		for (const key of Object.keys(flat))
+			if (key !== 'count')
+				result[key] = flat[key].slice();
+		return result;
+	} finally {
+		context.delete();
+	}
+}
+
+async function handle(message: any, reply: Reply): Promise<void>
+{
+	try {
+		if (message.type === 'init')
+		{
+			await init(message.module);
+			reply({ type: 'ready' }, []);
+			return;
+		}
+		const result = tessellate(message.points, message.options);
+		const transfer = Object.values(result).filter((v: any) => ArrayBuffer.isView(v)).map((v: any) => v.buffer);
+		reply({ result: result }, transfer);
+	} catch (e: any) {
+		// a trap or an abort of the module, e.g. when it runs out of memory,
+		// leaves it unusable, so the pool replaces this worker
+		reply({ error: e?.message ?? String(e), fatal: e instanceof WebAssembly.RuntimeError }, []);
+	}
+}
+
+// Node worker threads receive messages on their parent port, Web Workers on
+// their global scope.
+const scope = globalThis as any;
+if (typeof scope.process?.versions?.node === 'string')
+{
+	// imported by a computed name, hidden from bundlers of the browser build
+	const workerThreads: string = 'node:worker_threads';
+	const { parentPort } = await import(/* @vite-ignore */ workerThreads);
+	parentPort.on('message', (message: any) => handle(message, (reply, transfer) => parentPort.postMessage(reply, transfer)));
+}
+else
+{
+	scope.onmessage = (e: MessageEvent) => handle(e.data, (reply, transfer) => scope.postMessage(reply, transfer));
+}
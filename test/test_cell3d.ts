@@ -42,7 +42,8 @@ describe('Voro++ WebAssembly Wrapper Tests', function() {
             expect(cellData.volume).to.be.closeTo((xmax - xmin) * (ymax - ymin) * (zmax - zmin), 1e-9);
             expect(cellData.vertices).to.have.lengthOf(8);
             expect(cellData.faces).to.have.lengthOf(6);
-            expect(cellData.edges).to.be.an('array');
+            expect(cellData.edges).to.have.lengthOf(12);
+            cellData.edges.forEach((edge: number[]) => expect(edge[0]).to.be.lessThan(edge[1]));
             expect(cellData.neighbors).to.be.an('array');
         });
 
@@ -1,5 +1,5 @@
 import { expect } from 'chai';
-import { initializeVoro, VoroAPI, VoronoiContext3D } from '../dist/index.js';
+import { initializeVoro, createVoroWorkerPool, VoroAPI, VoronoiContext3D, VoronoiContextPoly3D, CellFields } from '../dist/index.js';
 
 describe('Voro++ WebAssembly Wrapper Tests', function() {
     this.timeout(10000); // Increase timeout for Emscripten module loading
@@ -91,16 +91,200 @@ describe('Voro++ WebAssembly Wrapper Tests', function() {
             }
         });
 
-        /*
+        it('should add points from typed arrays', function() {
+            context.addPointsFlat(new Int32Array([0, 1]), new Float64Array([1, 1, 1, 9, 9, 9]));
+            context.addPointsSoA(new Int32Array([2, 3]), new Float64Array([1, 9]), new Float64Array([9, 1]), new Float64Array([5, 5]));
+            const cells = context.getCells();
+            expect(cells).to.have.lengthOf(4);
+
+            const cell3 = cells.find((c: any) => c.id === 3);
+            expect(cell3).to.exist;
+            expect(cell3!.position.x).to.be.closeTo(9, 1e-9);
+            expect(cell3!.position.y).to.be.closeTo(1, 1e-9);
+            expect(cell3!.position.z).to.be.closeTo(5, 1e-9);
+        });
+
+        it('should move and remove points consistently with a rebuild', function() {
+            // Deterministic pseudo-random points.
+            let seed = 1;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const points: number[][] = [];
+            for (let i = 0; i < 50; i++) {
+                points.push([10 * rand(), 10 * rand(), 10 * rand()]);
+                context.addPoint(i, points[i][0], points[i][1], points[i][2]);
+            }
+            context.getCells();
+
+            points[7] = [5, 5, 5];
+            expect(context.movePoint(7, 5, 5, 5)).to.be.true;
+            expect(context.removePoint(11)).to.be.true;
+            expect(context.removePoint(11)).to.be.false;
+            // A move out of the container is rejected and keeps the particle.
+            expect(context.movePoint(12, 20, 5, 5)).to.be.false;
+            const cells = context.getCells();
+            const cell12 = cells.find((c: any) => c.id === 12);
+            expect(cell12).to.exist;
+            expect([cell12.position.x, cell12.position.y, cell12.position.z]).to.deep.equal(points[12]);
+
+            const reference = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, 10, 10, 10);
+            try {
+                points.forEach((p, i) => {
+                    if (i !== 11)
+                        reference.addPoint(i, p[0], p[1], p[2]);
+                });
+                const expected = reference.getCells();
+                expect(cells).to.have.lengthOf(expected.length);
+                expected.forEach((e: any) => {
+                    const cell = cells.find((c: any) => c.id === e.id);
+                    expect(cell).to.exist;
+                    expect(cell.volume).to.be.closeTo(e.volume, 1e-9);
+                    expect(cell.neighbors.slice().sort()).to.deep.equal(e.neighbors.slice().sort());
+                });
+            } finally {
+                reference.delete();
+            }
+        });
+
+        it('should keep cached cells consistent when adding points one at a time', function() {
+            let seed = 41;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const points: number[][] = [];
+            for (let i = 0; i < 40; i++)
+                points.push([10 * rand(), 10 * rand(), 10 * rand()]);
+            points.slice(0, 20).forEach((p, i) => context.addPoint(i, p[0], p[1], p[2]));
+            // A single lookup caches one cell, the others are cached by getCells.
+            context.getCellById(0);
+            points.slice(20, 30).forEach((p, i) => context.addPoint(20 + i, p[0], p[1], p[2]));
+            context.getCells();
+            points.slice(30).forEach((p, i) => context.addPoint(30 + i, p[0], p[1], p[2]));
+            const cells = context.getCells();
+
+            const reference = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, 10, 10, 10);
+            try {
+                points.forEach((p, i) => reference.addPoint(i, p[0], p[1], p[2]));
+                const expected = reference.getCells();
+                expect(cells).to.have.lengthOf(expected.length);
+                expected.forEach((e: any) => {
+                    const cell = cells.find((c: any) => c.id === e.id);
+                    expect(cell.volume).to.be.closeTo(e.volume, 1e-9);
+                    expect(cell.neighbors.slice().sort()).to.deep.equal(e.neighbors.slice().sort());
+                });
+            } finally {
+                reference.delete();
+            }
+        });
+
+        it('should give the same flat output for any number of threads', function() {
+            let seed = 3;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const ids = new Int32Array(2000);
+            const xyz = new Float64Array(3 * ids.length);
+            for (let i = 0; i < ids.length; i++) {
+                ids[i] = i;
+                xyz[3 * i] = 10 * rand();
+                xyz[3 * i + 1] = 10 * rand();
+                xyz[3 * i + 2] = 10 * rand();
+            }
+            context.addPointsFlat(ids, xyz);
+
+            context.setThreads(1);
+            expect(context.getThreads()).to.equal(1);
+            const single = context.getCellsFlat();
+            const singleIds = single.ids.slice();
+            const singleVolumes = single.volumes.slice();
+
+            context.setThreads(4);
+            expect(context.getThreads()).to.be.within(1, 4);
+            const multi = context.getCellsFlat();
+            expect(Array.from(multi.ids)).to.deep.equal(Array.from(singleIds));
+            for (let i = 0; i < multi.count; i++)
+                expect(multi.volumes[i]).to.be.closeTo(singleVolumes[i], 1e-12);
+        });
+
+        it('should compute volume and centroid of a single box cell', function() {
+            context.addPoint(0, 1, 2, 3);
+            const flat = context.getCellsFlat();
+            expect(flat.volumes[0]).to.be.closeTo(1000, 1e-9);
+            expect(Array.from(flat.centroids)).to.have.lengthOf(3);
+            flat.centroids.forEach((c: number) => expect(c).to.be.closeTo(5, 1e-9));
+        });
+
+        it('should return flat typed arrays consistent with getCells', function() {
+            context.addPoint(0, 2, 2, 2);
+            context.addPoint(1, 8, 2, 2);
+            context.addPoint(2, 5, 8, 5);
+
+            const cells = context.getCells();
+            const flat = context.getCellsFlat();
+            expect(flat.count).to.equal(3);
+            expect(flat.ids).to.be.an.instanceOf(Int32Array);
+            expect(flat.vertices).to.be.an.instanceOf(Float64Array);
+            expect(flat.vertexOffsets).to.have.lengthOf(4);
+            expect(flat.faceOffsets).to.have.lengthOf(4);
+
+            for (let i = 0; i < flat.count; i++) {
+                const cell = cells.find((c: any) => c.id === flat.ids[i]);
+                expect(cell).to.exist;
+                expect(flat.volumes[i]).to.be.closeTo(cell.volume, 1e-9);
+                expect(flat.vertexOffsets[i + 1] - flat.vertexOffsets[i]).to.equal(cell.vertices.length);
+                expect(flat.faceOffsets[i + 1] - flat.faceOffsets[i]).to.equal(cell.faces.length);
+                expect(flat.edgeOffsets[i + 1] - flat.edgeOffsets[i]).to.equal(cell.edges.length);
+            }
+            expect(flat.neighbors).to.have.lengthOf(flat.faceOffsets[3]);
+            expect(flat.faceVertexOffsets).to.have.lengthOf(flat.faceOffsets[3] + 1);
+        });
+
+        it('should only extract the requested fields', function() {
+            context.addPoint(0, 2, 2, 2);
+            context.addPoint(1, 8, 2, 2);
+            context.addPoint(2, 5, 8, 5);
+
+            const full = context.getCells();
+            const volumes = context.getCells(CellFields.VOLUME);
+            expect(volumes).to.have.lengthOf(3);
+            volumes.forEach((cell: any, i: number) => {
+                expect(cell.id).to.equal(full[i].id);
+                expect(cell.volume).to.be.closeTo(full[i].volume, 1e-9);
+                expect(cell.vertices).to.have.lengthOf(0);
+                expect(cell.faces).to.have.lengthOf(0);
+                expect(cell.edges).to.have.lengthOf(0);
+                expect(cell.neighbors).to.have.lengthOf(0);
+            });
+
+            const cell = context.getCellById(0, CellFields.NEIGHBORS | CellFields.FACES);
+            expect(cell.volume).to.equal(0);
+            expect(cell.neighbors).to.have.lengthOf(cell.faces.length);
+            expect(cell.neighbors).to.include(1);
+
+            const flat = context.getCellsFlat(CellFields.VERTICES | CellFields.EDGES);
+            expect(flat.count).to.equal(3);
+            expect(flat.volumes).to.have.lengthOf(0);
+            expect(flat.neighbors).to.have.lengthOf(0);
+            expect(flat.vertexOffsets[3]).to.equal(full.reduce((n: number, c: any) => n + c.vertices.length, 0));
+        });
+
         it('should retrieve a cell by its ID', function() {
             context.addPoint(100, 5, 5, 5);
+            context.addPoint(7, 2, 2, 2);
 
             const cell = context.getCellById(100);
-            
-            // TODO: implement
-   
+            expect(cell.id).to.equal(100);
+            expect(cell.position.x).to.be.closeTo(5, 1e-9);
+            expect(cell.volume).to.be.greaterThan(0);
+            expect(cell.neighbors).to.include(7);
+        });
 
-        });*/
+        it('should retrieve a batch of cells by their IDs', function() {
+            context.addPoint(3, 2, 2, 2);
+            context.addPoint(5, 8, 8, 8);
+            context.addPoint(9, 2, 8, 5);
+
+            const flat = context.getCellsByIds(new Int32Array([9, 42, 3]));
+            expect(flat.count).to.equal(2);
+            expect(Array.from(flat.ids)).to.deep.equal([9, 3]);
+            expect(flat.positions[0]).to.be.closeTo(2, 1e-9);
+            expect(flat.positions[1]).to.be.closeTo(8, 1e-9);
+        });
 
         /*it('should relax Voronoi cells and return new centroids', function() {
             context.addPoint(0, 1, 1, 1);
@@ -123,6 +307,460 @@ describe('Voro++ WebAssembly Wrapper Tests', function() {
             });
         });*/
 
+        it('should relax the points in place and keep their ids', function() {
+            const ids = [3, 40, 7, 1000];
+            const xyz = [1, 1, 1, 9, 1, 1, 1, 9, 1, 1, 1, 9];
+            ids.forEach((id, i) => context.addPoint(id, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]));
+
+            const centroids = context.relaxVoronoi();
+            expect(centroids.size()).to.equal(4);
+            centroids.delete();
+
+            const result = context.relax(200, 1e-6);
+            expect(result.iterations).to.be.within(1, 200);
+            expect(result.maxDisplacement).to.have.lengthOf(result.iterations);
+            expect(result.meanDisplacement).to.have.lengthOf(result.iterations);
+            expect(result.maxDisplacement[0]).to.be.greaterThan(result.maxDisplacement[result.iterations - 1]);
+            if (result.converged)
+                expect(result.maxDisplacement[result.iterations - 1]).to.be.at.most(1e-6);
+
+            const cells = context.getCells();
+            expect(cells.map((c: any) => c.id).sort((a: number, b: number) => a - b)).to.deep.equal([3, 7, 40, 1000]);
+            // Every particle sits (nearly) at the centroid of its cell.
+            const flat = context.getCellsFlat(CellFields.VOLUME);
+            for (let i = 0; i < 3 * flat.count; i++)
+                expect(flat.positions[i]).to.be.closeTo(flat.centroids[i], 0.05);
+        });
+
+        it('should give the same cells for sorted and unsorted bulk insertion', function() {
+            let seed = 11;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 1000;
+            const ids = new Int32Array(n).map((_, i) => 3 * i);
+            // Some of the points lie outside of the container and are skipped.
+            const xyz = new Float64Array(3 * n).map(() => 11 * rand() - 0.5);
+            const unsorted = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, 10, 10, 10);
+            try {
+                unsorted.setSortedInsert(false);
+                unsorted.addPointsFlat(ids, xyz);
+                context.addPointsFlat(ids, xyz);
+                const a = context.getCellsFlat(CellFields.VOLUME);
+                const b = unsorted.getCellsFlat(CellFields.VOLUME);
+                expect(a.count).to.equal(b.count);
+                expect(a.count).to.be.lessThan(n);
+                const volumes = new Map<number, number>();
+                for (let i = 0; i < b.count; i++)
+                    volumes.set(b.ids[i], b.volumes[i]);
+                for (let i = 0; i < a.count; i++)
+                    expect(a.volumes[i]).to.be.closeTo(volumes.get(a.ids[i])!, 1e-9);
+                // The index points to the sorted slots.
+                expect(context.getCellById(a.ids[0]).volume).to.be.closeTo(a.volumes[0], 1e-9);
+            } finally {
+                unsorted.delete();
+            }
+        });
+
+        it('should size and re-block the grid automatically', function() {
+            const auto = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10);
+            try {
+                expect(auto.getGrid()).to.deep.equal([1, 1, 1]);
+                const n = 2000;
+                const ids = new Int32Array(n).map((_, i) => i);
+                let seed = 5;
+                const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+                const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+                auto.addPointsFlat(ids, xyz);
+                context.addPointsFlat(ids, xyz);
+
+                const flat = auto.getCellsFlat(CellFields.VOLUME);
+                const grid = auto.getGrid();
+                // About 5.6 particles per block.
+                expect(grid[0] * grid[1] * grid[2]).to.be.within(n / 5.6 / 2, n / 5.6 * 2);
+                const expected = context.getCellsFlat(CellFields.VOLUME);
+                expect(flat.count).to.equal(expected.count);
+                const volume = (f: any, id: number) => f.volumes[Array.from(f.ids).indexOf(id)];
+                for (const id of [0, 500, 1999])
+                    expect(volume(flat, id)).to.be.closeTo(volume(expected, id), 1e-9);
+
+                const sized = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, n);
+                expect(sized.getGrid()).to.deep.equal(grid);
+                sized.delete();
+            } finally {
+                auto.delete();
+            }
+        });
+
+        it('should tessellate periodic containers without ghost particles', function() {
+            const periodic = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, 5, 5, 5, true, true, true);
+            try {
+                // A 2x2x2 lattice, partly given by periodic images outside of the box.
+                let id = 0;
+                for (const x of [2.5, 7.5])
+                    for (const y of [2.5, 7.5])
+                        for (const z of [2.5, -2.5])
+                            periodic.addPoint(id++, x + 10, y, z);
+                const flat = periodic.getCellsFlat();
+                expect(flat.count).to.equal(8);
+                for (let i = 0; i < flat.count; i++)
+                    expect(flat.volumes[i]).to.be.closeTo(125, 1e-9);
+                const cell = periodic.getCellById(1);
+                expect(cell.position.x).to.be.closeTo(2.5, 1e-12);
+                expect(cell.position.z).to.be.closeTo(7.5, 1e-12);
+                expect(cell.neighbors).to.have.lengthOf(6);
+            } finally {
+                periodic.delete();
+            }
+        });
+
+        it('should tessellate triclinic periodic boxes', function() {
+            const periodic = new Voro.VoronoiContextPeriodic3D(10, 4, 10, -3, 2, 10, 4, 4, 4);
+            try {
+                let seed = 3;
+                const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+                const n = 300;
+                const ids = new Int32Array(n).map((_, i) => i);
+                const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+                periodic.addPointsFlat(ids, xyz);
+                const flat = periodic.getCellsFlat(CellFields.VOLUME);
+                expect(flat.count).to.equal(n);
+                // The cells fill the box, whose volume is bx * by * bz.
+                const total = flat.volumes.reduce((a: number, b: number) => a + b, 0);
+                expect(total).to.be.closeTo(1000, 1e-6);
+                expect(periodic.getCellById(7).volume).to.be.closeTo(flat.volumes[Array.from(flat.ids).indexOf(7)], 1e-9);
+            } finally {
+                periodic.delete();
+            }
+        });
+
+        it('should compute all cells in chunks', function() {
+            let seed = 13;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 1000;
+            const ids = new Int32Array(n).map((_, i) => i);
+            const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+            context.addPointsFlat(ids, xyz);
+            const expected = context.getCellsFlat(CellFields.VOLUME);
+            const expectedIds = expected.ids.slice();
+            const expectedVolumes = expected.volumes.slice();
+
+            expect(context.isDone()).to.be.true;
+            context.beginCompute(CellFields.VOLUME);
+            expect(context.isDone()).to.be.false;
+            let chunks = 0;
+            let flat = context.computeChunk(300);
+            for (chunks = 1; !context.isDone(); chunks++) {
+                expect(flat.count).to.equal(300 * chunks);
+                flat = context.computeChunk(300, 1000);
+            }
+            expect(chunks).to.equal(4);
+            expect(flat.count).to.equal(n);
+            expect(Array.from(flat.ids)).to.deep.equal(Array.from(expectedIds));
+            for (let i = 0; i < n; i++)
+                expect(flat.volumes[i]).to.be.closeTo(expectedVolumes[i], 1e-12);
+            // The finished computation keeps its result.
+            expect(context.computeChunk(300).count).to.equal(n);
+        });
+
+        it('should cancel a chunked computation when the context changes', function() {
+            for (let i = 0; i < 8; i++)
+                context.addPoint(i, i & 1 ? 7.5 : 2.5, i & 2 ? 7.5 : 2.5, i & 4 ? 7.5 : 2.5);
+            context.beginCompute(CellFields.VOLUME);
+            expect(context.computeChunk(3).count).to.equal(3);
+            context.addPoint(8, 5, 5, 5);
+            expect(context.isDone()).to.be.true;
+            expect(context.computeChunk(3).count).to.equal(0);
+
+            context.beginCompute(CellFields.VOLUME);
+            context.computeChunk(3);
+            context.cancelCompute();
+            expect(context.isDone()).to.be.true;
+            expect(context.computeChunk(3).count).to.equal(0);
+
+            // A restarted computation sees the new particle.
+            context.beginCompute(CellFields.VOLUME);
+            const flat = context.computeChunk(0);
+            expect(context.isDone()).to.be.true;
+            expect(flat.count).to.equal(9);
+        });
+
+        it('should compute every cell once while queries run between the chunks', function() {
+            // Clustered particles in an automatically blocked container, whose
+            // blocks are estimated anew by every query.
+            const auto = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10);
+            try {
+                let seed = 31;
+                const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+                const n = 2000;
+                const xyz = new Float64Array(3 * n).map((_, k) => k % 3 === 0 ? 10 * rand() : 1 + rand());
+                auto.addPointsFlat(new Int32Array(n).map((_, i) => i), xyz);
+                auto.beginCompute(CellFields.VOLUME);
+                const grid = auto.getGrid();
+                let flat = auto.computeChunk(150);
+                while (!auto.isDone()) {
+                    expect(auto.getCellsFlat(CellFields.VOLUME).count).to.equal(n);
+                    expect(auto.locatePoints(new Float64Array([5, 1.5, 1.5]))[0]).to.be.at.least(0);
+                    expect(auto.getGrid()).to.deep.equal(grid);
+                    flat = auto.computeChunk(150);
+                }
+                const ids = Array.from(flat.ids).sort((a, b) => a - b);
+                expect(ids).to.deep.equal(Array.from({ length: n }, (_, i) => i));
+            } finally {
+                auto.delete();
+            }
+        });
+
+        it('should keep the batched walls of a chunked computation across queries', function() {
+            let seed = 17;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 200;
+            context.addPointsFlat(new Int32Array(n).map((_, i) => i), new Float64Array(3 * n).map(() => 10 * rand()));
+            // Keep x <= 7, as a plane relative to each particle.
+            let calls = 0;
+            context.addWallJSBatched({
+                cut_cells(positions: Float64Array) {
+                    calls++;
+                    const rows = new Float64Array(positions.length / 3 * 5);
+                    for (let i = 0; i < positions.length / 3; i++)
+                        rows.set([1, 1, 0, 0, 2 * (7 - positions[3 * i])], 5 * i);
+                    return rows;
+                }
+            }, -1);
+            const expected = context.getCellsFlat(CellFields.VOLUME);
+            const expectedVolumes = expected.volumes.slice();
+
+            calls = 0;
+            context.beginCompute(CellFields.VOLUME);
+            let flat = context.computeChunk(50);
+            while (!context.isDone()) {
+                // A bulk query between the chunks prepares its own rows.
+                expect(context.getCellsFlat(CellFields.VOLUME).count).to.equal(expected.count);
+                flat = context.computeChunk(50);
+            }
+            // One call for the chunked computation and one per bulk query.
+            expect(calls).to.equal(1 + 3);
+            expect(flat.count).to.equal(expected.count);
+            for (let i = 0; i < flat.count; i++)
+                expect(flat.volumes[i]).to.be.closeTo(expectedVolumes[i], 1e-12);
+        });
+
+        it('should export the neighbor graph in CSR form', function() {
+            let seed = 21;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 500;
+            context.addPointsFlat(new Int32Array(n).map((_, i) => i), new Float64Array(3 * n).map(() => 10 * rand()));
+            const flat = context.getCellsFlat(CellFields.NEIGHBORS);
+            const rows = Array.from(flat.ids);
+            const expected = rows.map((_, i) => Array.from(flat.neighbors.slice(flat.faceOffsets[i], flat.faceOffsets[i + 1])));
+
+            const graph = context.getNeighborGraph();
+            expect(graph.count).to.equal(n);
+            expect(graph.areas).to.be.undefined;
+            expect(Array.from(graph.ids)).to.deep.equal(rows);
+            for (let i = 0; i < n; i++) {
+                const neighbors = Array.from(graph.neighbors.slice(graph.offsets[i], graph.offsets[i + 1]));
+                const walls = Array.from(graph.walls.slice(graph.wallOffsets[i], graph.wallOffsets[i + 1]));
+                expect(neighbors).to.deep.equal(expected[i].filter(id => id >= 0));
+                expect(walls).to.deep.equal(expected[i].filter(id => id < 0));
+            }
+        });
+
+        it('should weight the neighbor graph by the shared face areas', function() {
+            // Eight cubes of edge 5, each touching three cubes and three box faces.
+            for (let i = 0; i < 8; i++)
+                context.addPoint(i, i & 1 ? 7.5 : 2.5, i & 2 ? 7.5 : 2.5, i & 4 ? 7.5 : 2.5);
+            const graph = context.getNeighborGraph(true);
+            expect(graph.count).to.equal(8);
+            expect(graph.neighbors.length).to.equal(24);
+            expect(graph.walls.length).to.equal(24);
+            for (let i = 0; i < 24; i++) {
+                expect(graph.areas![i]).to.be.closeTo(25, 1e-9);
+                expect(graph.wallAreas![i]).to.be.closeTo(25, 1e-9);
+            }
+            const row = Array.from(graph.ids).indexOf(0);
+            const neighbors = Array.from(graph.neighbors.slice(graph.offsets[row], graph.offsets[row + 1]));
+            expect(neighbors.sort()).to.deep.equal([1, 2, 4]);
+        });
+
+        it('should triangulate the cells into a render mesh', function() {
+            for (let i = 0; i < 8; i++)
+                context.addPoint(i, i & 1 ? 7.5 : 2.5, i & 2 ? 7.5 : 2.5, i & 4 ? 7.5 : 2.5);
+            // Sums the triangle areas of a mesh and checks that they wind
+            // counterclockwise around the normals of their vertices.
+            const surface = (mesh: any) => {
+                let area = 0;
+                for (let t = 0; t < mesh.indices.length; t += 3) {
+                    const [a, b, c] = [0, 1, 2].map(k => mesh.vertices.subarray(6 * mesh.indices[t + k], 6 * mesh.indices[t + k] + 6));
+                    const u = [0, 1, 2].map(k => b[k] - a[k]), v = [0, 1, 2].map(k => c[k] - a[k]);
+                    const n = [u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]];
+                    expect(n[0] * a[3] + n[1] * a[4] + n[2] * a[5]).to.be.greaterThan(0);
+                    area += 0.5 * Math.hypot(n[0], n[1], n[2]);
+                }
+                return area;
+            };
+
+            const flat = context.getRenderMesh();
+            expect(flat.count).to.equal(8);
+            expect(flat.vertexOffsets[1]).to.equal(24);
+            expect(flat.indexOffsets[1]).to.equal(36);
+            expect(flat.indices.length).to.equal(8 * 36);
+            expect(surface(flat)).to.be.closeTo(8 * 150, 1e-3);
+
+            const shrunk = context.getRenderMesh({ flatNormals: false, shrink: 0.5 });
+            expect(shrunk.vertexOffsets[1]).to.equal(8);
+            expect(shrunk.indices.length).to.equal(8 * 36);
+            expect(surface(shrunk)).to.be.closeTo(8 * 150 / 4, 1e-3);
+            // The shrunk cell of particle 0 spans [1.25, 3.75] on every axis.
+            const row = Array.from(shrunk.ids).indexOf(0);
+            for (let v = shrunk.vertexOffsets[row]; v < shrunk.vertexOffsets[row + 1]; v++)
+                for (let k = 0; k < 3; k++)
+                    expect(Math.abs(shrunk.vertices[6 * v + k] - 2.5)).to.be.closeTo(1.25, 1e-6);
+        });
+
+        it('should return every edge of the wireframe once', function() {
+            for (let i = 0; i < 8; i++)
+                context.addPoint(i, i & 1 ? 7.5 : 2.5, i & 2 ? 7.5 : 2.5, i & 4 ? 7.5 : 2.5);
+            // A 2x2x2 grid of cubes has 3 x 9 lines of two edges each, while
+            // the cells have 12 edges each.
+            const wireframe = context.getWireframe();
+            expect(wireframe.count).to.equal(54);
+            expect(wireframe.segments.length).to.equal(6 * 54);
+            let length = 0;
+            for (let i = 0; i < wireframe.segments.length; i += 6)
+                length += Math.hypot(wireframe.segments[i + 3] - wireframe.segments[i],
+                    wireframe.segments[i + 4] - wireframe.segments[i + 1], wireframe.segments[i + 5] - wireframe.segments[i + 2]);
+            expect(length).to.be.closeTo(270, 1e-4);
+        });
+
+        it('should return flat output in single precision', function() {
+            let seed = 9;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 200;
+            context.addPointsFlat(new Int32Array(n).map((_, i) => i), new Float64Array(3 * n).map(() => 10 * rand()));
+            const double = context.getCellsFlat();
+            const vertices = double.vertices.slice();
+            const volumes = double.volumes.slice();
+            expect(double.vertices).to.be.an.instanceOf(Float64Array);
+
+            context.setPrecision(32);
+            const single = context.getCellsFlat();
+            expect(single.vertices).to.be.an.instanceOf(Float32Array);
+            expect(single.volumes).to.be.an.instanceOf(Float32Array);
+            expect(single.vertices.length).to.equal(vertices.length);
+            for (let i = 0; i < n; i++)
+                expect(single.volumes[i]).to.be.closeTo(volumes[i], 1e-5);
+            for (let k = 0; k < vertices.length; k++)
+                expect(single.vertices[k]).to.be.closeTo(vertices[k], 1e-5);
+
+            // Relative vertices plus the position of their particle.
+            context.setPrecision(32, true);
+            const relative = context.getCellsFlat();
+            for (let i = 0; i < n; i++)
+                for (let v = relative.vertexOffsets[i]; v < relative.vertexOffsets[i + 1]; v++)
+                    for (let a = 0; a < 3; a++)
+                        expect(relative.vertices[3 * v + a] + relative.positions[3 * i + a]).to.be.closeTo(vertices[3 * v + a], 1e-5);
+
+            // The chunks convert only their new cells, giving the same result.
+            context.beginCompute();
+            let chunked = context.computeChunk(70);
+            while (!context.isDone())
+                chunked = context.computeChunk(70);
+            expect(chunked.vertices).to.be.an.instanceOf(Float32Array);
+            expect(Array.from(chunked.vertices)).to.deep.equal(Array.from(relative.vertices));
+            expect(Array.from(chunked.volumes)).to.deep.equal(Array.from(relative.volumes));
+
+            context.setPrecision(64);
+            expect(context.getCellsFlat().vertices).to.be.an.instanceOf(Float64Array);
+        });
+
+        it('should reject precisions other than 32 and 64 bits', function() {
+            expect(() => context.setPrecision(16 as any)).to.throw();
+            expect(() => context.setPrecision(0 as any, true)).to.throw();
+            context.addPoint(0, 5, 5, 5);
+            // The precision is unchanged.
+            expect(context.getCellsFlat().vertices).to.be.an.instanceOf(Float64Array);
+        });
+
+        it('should locate the cells containing given positions', function() {
+            let seed = 17;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 300;
+            const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+            context.addPointsFlat(new Int32Array(n).map((_, i) => i), xyz);
+
+            // The cell containing a position belongs to the nearest particle.
+            const m = 2000;
+            const queries = new Float64Array(3 * m).map(() => 10 * rand());
+            const located = context.locatePoints(queries);
+            expect(located.length).to.equal(m);
+            for (let q = 0; q < m; q++) {
+                let nearest = -1, best = Infinity;
+                for (let i = 0; i < n; i++) {
+                    const d = Math.hypot(queries[3 * q] - xyz[3 * i], queries[3 * q + 1] - xyz[3 * i + 1], queries[3 * q + 2] - xyz[3 * i + 2]);
+                    if (d < best) { best = d; nearest = i; }
+                }
+                expect(located[q]).to.equal(nearest);
+            }
+
+            expect(Array.from(context.locatePoints(new Float64Array([-1, 5, 5, 5, 5, 11])))).to.deep.equal([-1, -1]);
+        });
+
+        it('should count only the particles inserted by the user', function() {
+            const auto = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10);
+            try {
+                auto.setStatsEnabled(true);
+                let seed = 29;
+                const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+                const n = 1000;
+                const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+                // Two particles lie outside of the container and are skipped.
+                xyz.set([11, 5, 5, 5, -1, 5], 0);
+                auto.addPointsFlat(new Int32Array(n).map((_, i) => i), xyz);
+                auto.addPoint(n, 5, 5, 20);
+                expect(auto.getStats().particlesInserted).to.equal(n - 2);
+
+                // Re-blocking moves all particles, which is not an insertion.
+                expect(auto.getGrid()).to.deep.equal([1, 1, 1]);
+                auto.getCellsFlat(CellFields.VOLUME);
+                expect(auto.getGrid()).to.not.deep.equal([1, 1, 1]);
+                expect(auto.getStats().particlesInserted).to.equal(n - 2);
+            } finally {
+                auto.delete();
+            }
+        });
+
+        it('should collect statistics only while enabled', function() {
+            let seed = 5;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const ids = new Int32Array(100).map((_, i) => i);
+            const xyz = new Float64Array(300).map(() => 10 * rand());
+            context.addPointsFlat(ids, xyz);
+            context.getCellsFlat(CellFields.VOLUME);
+            expect(context.getStats().cellsComputed).to.equal(0);
+
+            context.setStatsEnabled(true);
+            context.addPoint(100, 5.05, 5.05, 5.05);
+            const flat = context.getCellsFlat(CellFields.VOLUME);
+            let stats = context.getStats();
+            expect(stats.enabled).to.be.true;
+            expect(stats.particlesInserted).to.equal(1);
+            expect(stats.cellsComputed).to.equal(flat.count);
+            expect(stats.cellsFailed).to.equal(0);
+            expect(stats.bytesEmitted).to.be.greaterThan(flat.count * 8);
+            expect(stats.computeMs).to.be.at.least(0);
+
+            // The planes of a JavaScript wall are requested once per cell.
+            context.addWallJS({
+                point_inside: () => true,
+                cut_cell: () => ({ cut: true, nx: 0, ny: 0, nz: 1, d: 20 })
+            });
+            context.resetStats();
+            const cells = context.getCells();
+            stats = context.getStats();
+            expect(stats.cellsComputed).to.equal(cells.length);
+            expect(stats.jsWallCalls).to.equal(cells.length);
+            expect(stats.jsWallMs).to.be.at.most(stats.computeMs);
+        });
+
         it('should clear all particles from the container', function() {
             context.addPoint(0, 1, 1, 1);
             const cellsBeforeClear = context.getCells();
@@ -142,6 +780,83 @@ describe('Voro++ WebAssembly Wrapper Tests', function() {
             expect(cells[0].volume).to.be.greaterThan(0);
         });
 
+        it('should add, remove and clear owned walls', function() {
+            context.addPoint(0, 5, 5, 5);
+            const volume = () => context.getCellsFlat(CellFields.VOLUME).volumes[0];
+
+            const plane = context.addWallPlane(1, 0, 0, 7, -1);
+            expect(volume()).to.be.closeTo(700, 1e-9);
+
+            // Keep x <= 6 and y <= 4 in addition.
+            const first = context.addWallPlanes(new Float64Array([1, 0, 0, 6, 0, 1, 0, 4]), -2);
+            expect(first).to.equal(plane + 1);
+            expect(volume()).to.be.closeTo(240, 1e-9);
+
+            expect(context.removeWall(first)).to.be.true;
+            expect(context.removeWall(first)).to.be.false;
+            expect(volume()).to.be.closeTo(280, 1e-9);
+
+            context.clearWalls();
+            expect(volume()).to.be.closeTo(1000, 1e-9);
+        });
+
+        it('should cut cells by native signed distance walls', function() {
+            context.addPoint(0, 5, 5, 5);
+            const volume = () => context.getCellsFlat(CellFields.VOLUME).volumes[0];
+
+            let wall = context.addWallSDF({ type: 'halfspace', normal: [1, 0, 0], d: 7 }, -1);
+            expect(volume()).to.be.closeTo(700, 1e-6);
+            context.removeWall(wall);
+
+            wall = context.addWallSDF({ type: 'intersection', children: [
+                { type: 'halfspace', normal: [2, 0, 0], d: 14 },
+                { type: 'halfspace', normal: [0, 1, 0], d: 4 }
+            ] }, -1);
+            expect(volume()).to.be.closeTo(280, 1e-6);
+            context.removeWall(wall);
+
+            // The particle lies outside of the box and is cut by its top face.
+            wall = context.addWallSDF({ type: 'box', min: [0, 0, 0], max: [10, 10, 4] }, -1);
+            expect(volume()).to.be.closeTo(400, 1e-6);
+            context.removeWall(wall);
+
+            // Inside of a box the cell is cut by all of its faces.
+            wall = context.addWallSDF({ type: 'box', min: [2, 2, 2], max: [8, 8, 9] }, -1);
+            expect(volume()).to.be.closeTo(252, 1e-6);
+            context.removeWall(wall);
+
+            // The halfspace x <= 7 sampled on a 2x2x2 grid.
+            const values = new Float64Array(8).map((_, i) => i % 2 ? 3 : -7);
+            context.addWallSDF({ type: 'grid', min: [0, 0, 0], max: [10, 10, 10], dims: [2, 2, 2], values }, -1);
+            expect(volume()).to.be.closeTo(700, 1e-6);
+        });
+
+        it('should cut cells by a batched JavaScript wall', function() {
+            context.addPoint(0, 5, 5, 5);
+            context.addPoint(1, 5, 5, 9);
+            context.addPoint(2, 5, 9, 5);
+            // Keep x <= 7, as a plane relative to each particle.
+            let calls = 0;
+            context.addWallJSBatched({
+                cut_cells(positions: Float64Array) {
+                    calls++;
+                    const rows = new Float64Array(positions.length / 3 * 5);
+                    for (let i = 0; i < positions.length / 3; i++)
+                        rows.set([1, 1, 0, 0, 2 * (7 - positions[3 * i])], 5 * i);
+                    return rows;
+                }
+            }, -1);
+
+            const flat = context.getCellsFlat(CellFields.VOLUME);
+            expect(calls).to.equal(1);
+            const total = Array.from(flat.volumes).reduce((a, b) => a + b, 0);
+            expect(total).to.be.closeTo(700, 1e-9);
+
+            const single = context.getCellById(0, CellFields.VOLUME);
+            expect(calls).to.equal(2);
+            expect(single.volume).to.be.closeTo(flat.volumes[Array.from(flat.ids).indexOf(0)], 1e-9);
+        });
+
         it('should handle a custom JavaScript wall correctly', function() {
             const mockJsWall = {
                 point_inside: function(x: number, y: number, z: number) {
@@ -169,4 +884,130 @@ describe('Voro++ WebAssembly Wrapper Tests', function() {
             expect(cell1!.volume).to.be.greaterThan(0);
         });
     });
+
+    describe('VoronoiContextPoly3D', function() {
+        let context: VoronoiContextPoly3D;
+
+        beforeEach(function() {
+            context = new Voro.VoronoiContextPoly3D(0, 10, 0, 10, 0, 10, 5, 5, 5);
+        });
+
+        afterEach(function() {
+            if (context) {
+                context.delete();
+            }
+        });
+
+        it('should place the faces by the radical (power) distance', function() {
+            // The power distances |x - 3|^2 - 2^2 and |x - 7|^2 are equal at x = 5.5.
+            context.addPoint(0, 3, 5, 5, 2);
+            context.addPoint(1, 7, 5, 5, 0);
+            expect(context.getCellById(0).volume).to.be.closeTo(550, 1e-9);
+            expect(context.getCellById(1).volume).to.be.closeTo(450, 1e-9);
+
+            // Moving a particle keeps its radius, the faces meet at x = 4.9.
+            expect(context.movePoint(0, 2, 5, 5)).to.be.true;
+            const flat = context.getCellsFlat(CellFields.VOLUME);
+            const volume = (id: number) => flat.volumes[Array.from(flat.ids).indexOf(id)];
+            expect(volume(0)).to.be.closeTo(490, 1e-9);
+            expect(volume(1)).to.be.closeTo(510, 1e-9);
+        });
+
+        it('should bulk load particles with radii', function() {
+            let seed = 7;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const n = 500;
+            const ids = new Int32Array(n).map((_, i) => i);
+            const xyz = new Float64Array(3 * n).map(() => 10 * rand());
+            const radii = new Float64Array(n).map(() => 0.1 + 0.3 * rand());
+            context.addPointsFlat(ids, xyz, radii);
+            const flat = context.getCellsFlat(CellFields.VOLUME);
+            expect(flat.count).to.equal(n);
+            const total = flat.volumes.reduce((a: number, b: number) => a + b, 0);
+            expect(total).to.be.closeTo(1000, 1e-6);
+
+            // The same particles added one by one give the same cells.
+            const single = new Voro.VoronoiContextPoly3D(0, 10, 0, 10, 0, 10, 5, 5, 5);
+            try {
+                for (let i = 0; i < n; i++)
+                    single.addPoint(i, xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2], radii[i]);
+                for (const id of [0, 250, 499])
+                    expect(single.getCellById(id).volume).to.be.closeTo(flat.volumes[Array.from(flat.ids).indexOf(id)], 1e-9);
+            } finally {
+                single.delete();
+            }
+
+            expect(() => context.addPointsFlat(ids, xyz, new Float64Array(n - 1))).to.throw();
+        });
+    });
+
+    describe('createVoroWorkerPool', function() {
+        it('should tessellate independent containers in parallel', async function() {
+            let seed = 17;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const sets = [200, 300, 400].map((n) => new Float64Array(3 * n).map(() => 10 * rand()));
+            const pool = await createVoroWorkerPool(2);
+            try {
+                expect(pool.size).to.equal(2);
+                const results = await Promise.all(sets.map((points) =>
+                    pool.tessellate(points, { bounds: [0, 10, 0, 10, 0, 10], grid: [5, 5, 5], fields: CellFields.VOLUME })));
+                for (let s = 0; s < sets.length; s++)
+                {
+                    const context = new Voro.VoronoiContext3D(0, 10, 0, 10, 0, 10, 5, 5, 5);
+                    try {
+                        context.addPointsFlat(Int32Array.from({ length: sets[s].length / 3 }, (_, i) => i), sets[s]);
+                        const expected = context.getCellsFlat(CellFields.VOLUME);
+                        expect(results[s].count).to.equal(expected.count);
+                        expect(Array.from(results[s].ids)).to.deep.equal(Array.from(expected.ids));
+                        for (let i = 0; i < expected.count; i++)
+                            expect(results[s].volumes[i]).to.be.closeTo(expected.volumes[i], 1e-12);
+                    } finally {
+                        context.delete();
+                    }
+                }
+
+                // Errors of a worker reject the call and leave the worker usable.
+                let failed = false;
+                await pool.tessellate(new Float64Array(4), { bounds: [0, 10, 0, 10, 0, 10] }).catch(() => { failed = true; });
+                expect(failed).to.be.true;
+                const radical = await pool.tessellate(new Float64Array([3, 5, 5, 7, 5, 5]), { bounds: [0, 10, 0, 10, 0, 10], radii: new Float64Array([2, 0]) });
+                expect(radical.volumes[Array.from(radical.ids).indexOf(0)]).to.be.closeTo(550, 1e-9);
+            } finally {
+                pool.terminate();
+            }
+        });
+
+        it('should reject running tessellations when the pool is terminated', async function() {
+            const pool = await createVoroWorkerPool(1);
+            let seed = 37;
+            const rand = () => (seed = (seed * 16807) % 2147483647) / 2147483647;
+            const points = new Float64Array(3 * 20000).map(() => 10 * rand());
+            const options = { bounds: [0, 10, 0, 10, 0, 10] };
+            // The first container is running, the second one queued.
+            const results = [pool.tessellate(points, options), pool.tessellate(points, options)]
+                .map((p) => p.then(() => 'resolved', (e: Error) => e.message));
+            pool.terminate();
+            expect(await Promise.all(results)).to.deep.equal(['The worker pool was terminated', 'The worker pool was terminated']);
+        });
+
+        it('should replace a crashed worker', async function() {
+            const pool = await createVoroWorkerPool(1);
+            try {
+                // The blocks of a 1000^3 grid do not fit into memory, which
+                // aborts the module of the worker.
+                let error: Error | null = null;
+                await pool.tessellate(new Float64Array([5, 5, 5]), { bounds: [0, 10, 0, 10, 0, 10], grid: [1000, 1000, 1000] })
+                    .catch((e: Error) => { error = e; });
+                expect(error).to.be.an.instanceOf(Error);
+
+                // The next container is tessellated by a new worker.
+                const flat = await pool.tessellate(new Float64Array([2.5, 5, 5, 7.5, 5, 5]), { bounds: [0, 10, 0, 10, 0, 10] });
+                expect(pool.size).to.equal(1);
+                expect(flat.count).to.equal(2);
+                expect(flat.volumes[0] + flat.volumes[1]).to.be.closeTo(1000, 1e-9);
+            } finally {
+                pool.terminate();
+            }
+        });
+    });
 });